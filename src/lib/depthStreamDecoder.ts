@@ -0,0 +1,181 @@
+// DECODIFICADOR DEL FLUJO COMPACTO DE PROFUNDIDAD (FORMATO depth_stream NATIVO)
+// Réplica exacta de DepthStreamCodec.h: teselas independientes, máscara de validez,
+// predicción delta por fila y códigos Rice. Profundidad en mm, NaN si inválida
+
+const MAGIC = 'CMDS';
+const VERSION = 1;
+const HEADER_SIZE = 24;
+const RICE_ESCAPE = 24;
+const RAW_RESIDUAL_BITS = 17;
+
+const MASK_NONE = 0;
+const MASK_ALL = 1;
+const MASK_BITMAP = 2;
+
+export interface DepthStreamInfo {
+  width: number;
+  height: number;
+  tileSize: number;
+  tilesX: number;
+  tilesY: number;
+  stepMm: number;
+}
+
+export interface DecodedDepthFrame extends DepthStreamInfo {
+  data: Float32Array; // width * height, mm (NaN = sin profundidad)
+}
+
+// Lector de bits LSB primero; más allá del final devuelve ceros y marca el desbordamiento
+class BitReader {
+  private bytes: Uint8Array;
+  private position = 0;
+  private bitPosition = 0;
+
+  constructor(bytes: Uint8Array) {
+    this.bytes = bytes;
+  }
+
+  read(bits: number): number {
+    let value = 0;
+    for (let i = 0; i < bits; i++) {
+      const byte = this.position < this.bytes.length ? this.bytes[this.position] : 0;
+      value |= ((byte >> this.bitPosition) & 1) << i;
+      if (++this.bitPosition === 8) {
+        this.bitPosition = 0;
+        this.position++;
+      }
+    }
+    return value >>> 0;
+  }
+
+  readUnary(limit: number): number {
+    let count = 0;
+    while (count < limit && this.read(1) === 1) count++;
+    return count;
+  }
+
+  get overrun(): boolean {
+    return this.position > this.bytes.length || (this.position === this.bytes.length && this.bitPosition > 0);
+  }
+}
+
+function toBytes(input: ArrayBuffer | Uint8Array | string): Uint8Array {
+  if (typeof input === 'string') {
+    // Base64 tal como lo entrega MultiCameraModule.getDepthFrame
+    const binary = atob(input);
+    const bytes = new Uint8Array(binary.length);
+    for (let i = 0; i < binary.length; i++) bytes[i] = binary.charCodeAt(i);
+    return bytes;
+  }
+  return input instanceof Uint8Array ? input : new Uint8Array(input);
+}
+
+export function readDepthStreamInfo(input: ArrayBuffer | Uint8Array | string): DepthStreamInfo | null {
+  const bytes = toBytes(input);
+  if (bytes.length < HEADER_SIZE) return null;
+
+  const view = new DataView(bytes.buffer, bytes.byteOffset, bytes.byteLength);
+  const magic = String.fromCharCode(bytes[0], bytes[1], bytes[2], bytes[3]);
+  if (magic !== MAGIC || bytes[4] !== VERSION) return null;
+
+  const tileSize = view.getUint16(6, true);
+  const width = view.getUint16(8, true);
+  const height = view.getUint16(10, true);
+  const stepMm = view.getFloat32(12, true);
+  if (tileSize === 0) return null;
+
+  const tilesX = Math.ceil(width / tileSize);
+  const tilesY = Math.ceil(height / tileSize);
+  if (view.getUint32(16, true) !== tilesX * tilesY) return null;
+  if (bytes.length < HEADER_SIZE + 4 * (tilesX * tilesY + 1)) return null;
+
+  return { width, height, tileSize, tilesX, tilesY, stepMm };
+}
+
+// Decodifica una tesela (acceso aleatorio) en target con el stride dado (en elementos)
+export function decodeDepthTile(
+  input: ArrayBuffer | Uint8Array | string,
+  tileIndex: number,
+  target: Float32Array,
+  stride: number,
+  offset = 0
+): boolean {
+  const bytes = toBytes(input);
+  const info = readDepthStreamInfo(bytes);
+  if (!info || tileIndex < 0 || tileIndex >= info.tilesX * info.tilesY) return false;
+
+  const view = new DataView(bytes.buffer, bytes.byteOffset, bytes.byteLength);
+  const payloadStart = HEADER_SIZE + 4 * (info.tilesX * info.tilesY + 1);
+  const begin = payloadStart + view.getUint32(HEADER_SIZE + 4 * tileIndex, true);
+  const end = payloadStart + view.getUint32(HEADER_SIZE + 4 * (tileIndex + 1), true);
+  if (begin >= end || end > bytes.length) return false;
+
+  const tx = tileIndex % info.tilesX;
+  const ty = Math.floor(tileIndex / info.tilesX);
+  const width = Math.min(info.tileSize, info.width - tx * info.tileSize);
+  const height = Math.min(info.tileSize, info.height - ty * info.tileSize);
+
+  let cursor = begin;
+  const mode = bytes[cursor++];
+  if (mode === MASK_NONE) {
+    for (let y = 0; y < height; y++) target.fill(NaN, offset + y * stride, offset + y * stride + width);
+    return true;
+  }
+
+  let mask: Uint8Array | null = null;
+  if (mode === MASK_BITMAP) {
+    mask = bytes.subarray(cursor, cursor + Math.ceil((width * height) / 8));
+    cursor += Math.ceil((width * height) / 8);
+  } else if (mode !== MASK_ALL) {
+    return false;
+  }
+  if (cursor > end) return false;
+
+  const reader = new BitReader(bytes.subarray(cursor, end));
+  let rowStart = 0;
+  for (let y = 0; y < height; y++) {
+    const rowOffset = offset + y * stride;
+    const k = reader.read(4);
+    let previous = rowStart;
+    let first = true;
+
+    for (let x = 0; x < width; x++) {
+      const bit = y * width + x;
+      if (mask && !(mask[bit >> 3] & (1 << (bit & 7)))) {
+        target[rowOffset + x] = NaN;
+        continue;
+      }
+
+      const quotient = reader.readUnary(RICE_ESCAPE);
+      const residual = quotient < RICE_ESCAPE
+        ? quotient * (1 << k) + (k > 0 ? reader.read(k) : 0)
+        : reader.read(RAW_RESIDUAL_BITS);
+
+      // Zigzag inverso
+      const value = previous + ((residual & 1) ? -((residual + 1) >>> 1) : residual >>> 1);
+      if (first) {
+        rowStart = value;
+        first = false;
+      }
+      previous = value;
+      target[rowOffset + x] = value * info.stepMm;
+    }
+  }
+  return !reader.overrun;
+}
+
+// Decodifica el frame completo
+export function decodeDepthFrame(input: ArrayBuffer | Uint8Array | string): DecodedDepthFrame | null {
+  const bytes = toBytes(input);
+  const info = readDepthStreamInfo(bytes);
+  if (!info) return null;
+
+  const data = new Float32Array(info.width * info.height);
+  for (let ty = 0; ty < info.tilesY; ty++) {
+    for (let tx = 0; tx < info.tilesX; tx++) {
+      const offset = ty * info.tileSize * info.width + tx * info.tileSize;
+      if (!decodeDepthTile(bytes, ty * info.tilesX + tx, data, info.width, offset)) return null;
+    }
+  }
+  return { ...info, data };
+}
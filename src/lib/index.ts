@@ -11,6 +11,8 @@ export * from './types';
 // ============================================================================
 export { unifiedOpenCV, detectObjectsWithOpenCV } from './unifiedOpenCVSystem';
 export { real3DDepthCalculator, calculateDepthFromStereo, calculateObjectDepth, setSGBMParameters, calibrateSystem } from './realDepthCalculation';
+export { decodeDepthFrame, decodeDepthTile, readDepthStreamInfo } from './depthStreamDecoder';
+export type { DepthStreamInfo, DecodedDepthFrame } from './depthStreamDecoder';
 
 // ============================================================================
 // EXPORTACIÓN DE CONTEXTO
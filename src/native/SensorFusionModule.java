@@ -58,12 +58,14 @@ public class SensorFusionModule extends ReactContextBaseJavaModule implements Se
     private long collectionStartTime;
     
     // Native bridge para procesamiento en C++
+    // Misma librería que el procesador de cámaras: el historial de poses IMU se comparte en proceso
     static {
-        System.loadLibrary("sensorfusion");
+        System.loadLibrary("nativecameraprocessor");
     }
     
     // Declaraciones JNI para algoritmos de fusión avanzados
     private native void nativeInitializeFusion(int sensorCount);
+    private native void nativePushImuSample(int kind, float x, float y, float z, long timestampNs);
     private native void nativeProcessSensorData(float[] accelData, float[] gyroData, 
                                                float[] magData, float[] baroData, 
                                                double[] gpsData, long timestamp);
@@ -330,6 +332,13 @@ public class SensorFusionModule extends ReactContextBaseJavaModule implements Se
         String sensorType = getSensorTypeName(event.sensor.getType());
         long timestamp = event.timestamp;
         
+        // IMU directa al filtro nativo a frecuencia de sensor (sin esperar al sincronizador)
+        int sensorKind = event.sensor.getType();
+        if (sensorKind == Sensor.TYPE_ACCELEROMETER || sensorKind == Sensor.TYPE_GYROSCOPE) {
+            nativePushImuSample(sensorKind == Sensor.TYPE_GYROSCOPE ? 1 : 0,
+                               event.values[0], event.values[1], event.values[2], timestamp);
+        }
+        
         // Crear objeto de datos del sensor
         SensorData sensorData = new SensorData(
             event.values.clone(),
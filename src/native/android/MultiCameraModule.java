@@ -14,8 +14,10 @@ import android.media.ImageReader;
 import android.media.Image;
 import android.os.Handler;
 import android.os.HandlerThread;
+import android.util.Base64;
 import android.util.Size;
 import android.view.Surface;
+import java.io.File;
 import java.util.ArrayList;
 import java.util.Arrays;
 import java.util.List;
@@ -31,6 +33,7 @@ public class MultiCameraModule extends ReactContextBaseJavaModule {
     private static final String MODULE_NAME = "MultiCameraModule";
     private static final int MAX_CAMERAS = 4;
     private static final long SYNC_TOLERANCE_NS = 16_666_666L; // 16.67ms para 60fps
+    private static final double MIN_DEPTH_STEP_MM = 10000.0 / 65535.0; // depth_stream::kMinStepMm
     
     private ReactApplicationContext reactContext;
     private CameraManager cameraManager;
@@ -49,15 +52,42 @@ public class MultiCameraModule extends ReactContextBaseJavaModule {
     private boolean isCapturing;
     private int activeCameraCount;
     
+    // Handles opacos de los procesadores nativos (0 = sin procesador): medición y vista previa
+    // opcional, que comparte pool y calibración con el de medición. volatile: se escriben en
+    // los hilos de los métodos React y se leen en backgroundHandler al llegar cada frame
+    private volatile long processorHandle;
+    private volatile long previewHandle;
+    private int captureWidth;
+    private int captureHeight;
+    
     // Native bridge para C++
     static {
         System.loadLibrary("nativecameraprocessor");
     }
     
     // Declaraciones JNI para comunicación con C++
-    private native void nativeInitializeProcessor(int width, int height, int cameraCount);
-    private native void nativeProcessMultiFrame(byte[][] frameData, long[] timestamps, int[] cameraIds);
-    private native void nativeCleanup();
+    private native long nativeCreateProcessor(int width, int height, int cameraCount, long shareWithHandle);
+    private native void nativeProcessMultiFrame(long handle, byte[][] frameData, long[] timestamps, int[] cameraIds);
+    private native void nativeSetProcessingMode(long handle, int mode);
+    private native void nativeSetFeatureMatchMode(long handle, int mode);
+    private native void nativeSetCompactDescriptors(long handle, boolean enabled);
+    private native double[] nativeQueryDepthStatistics(long handle, int x, int y, int width, int height);
+    private native double[] nativeDetectPlane(long handle, int orientation);
+    private native byte[] nativeEncodeDepthFrame(long handle, float stepMm);
+    private native byte[][] nativeGenerateMesh(long handle, int triangleBudget);
+    private native double[] nativeQuerySurfaceNormal(long handle, int x, int y);
+    private native void nativeSetSharpnessGate(long handle, double minSharpness, double maxAngularRate);
+    private native void nativeSetStereoRegion(long handle, int x, int y, int width, int height);
+    private native boolean nativeRunCalibration(long handle);
+    private native boolean nativeSetReferencePlane(long handle, double normalX, double normalY, double normalZ,
+                                                   double offset, double cameraHeight);
+    private native double[] nativeMeasureOnReferencePlane(long handle, float[] pixels);
+    private native boolean nativeStartRecording(long handle, String path, int capacityMb);
+    private native void nativeStopRecording(long handle);
+    private native int nativeReplayRecording(long handle, String path);
+    private native long nativeExportPointCloud(long handle, String path, int source, boolean colors,
+                                               boolean confidence, float voxelSize);
+    private native void nativeDestroyProcessor(long handle);
 
     public MultiCameraModule(ReactApplicationContext reactContext) {
         super(reactContext);
@@ -71,6 +101,8 @@ public class MultiCameraModule extends ReactContextBaseJavaModule {
         this.cameraOpenCloseLock = new Semaphore(1);
         this.isCapturing = false;
         this.activeCameraCount = 0;
+        this.processorHandle = 0;
+        this.previewHandle = 0;
         
         startBackgroundThread();
     }
@@ -144,10 +176,17 @@ public class MultiCameraModule extends ReactContextBaseJavaModule {
                 .get(CameraCharacteristics.SCALER_STREAM_CONFIGURATION_MAP)
                 .getOutputSizes(android.graphics.ImageFormat.YUV_420_888));
             
-            nativeInitializeProcessor(
-                firstCameraSize.getWidth(), 
-                firstCameraSize.getHeight(), 
-                activeCameraCount
+            destroyPreviewHandle();
+            if (processorHandle != 0) {
+                nativeDestroyProcessor(processorHandle);
+            }
+            captureWidth = firstCameraSize.getWidth();
+            captureHeight = firstCameraSize.getHeight();
+            processorHandle = nativeCreateProcessor(
+                captureWidth, 
+                captureHeight, 
+                activeCameraCount,
+                0 // sin compartir pool ni calibración
             );
             
             WritableMap result = Arguments.createMap();
@@ -227,6 +266,475 @@ public class MultiCameraModule extends ReactContextBaseJavaModule {
         }
     }
 
+    /**
+     * Procesador de vista previa junto al de medición: mismos frames, pool y calibración, en
+     * modo preview-depth (media resolución). Se elige con pipeline = "preview"
+     */
+    @ReactMethod
+    public void createPreviewPipeline(Promise promise) {
+        long measurement = processorHandle;
+        if (measurement == 0) {
+            promise.reject("NO_PROCESSOR", "Procesador nativo no inicializado");
+            return;
+        }
+        
+        destroyPreviewHandle();
+        long preview = nativeCreateProcessor(captureWidth, captureHeight, activeCameraCount, measurement);
+        if (preview == 0) {
+            promise.reject("PREVIEW_FAILED", "No se pudo crear el procesador de vista previa");
+            return;
+        }
+        nativeSetProcessingMode(preview, 0);
+        previewHandle = preview;
+        promise.resolve(null);
+    }
+
+    @ReactMethod
+    public void destroyPreviewPipeline(Promise promise) {
+        destroyPreviewHandle();
+        promise.resolve(null);
+    }
+
+    private void destroyPreviewHandle() {
+        long preview = previewHandle;
+        previewHandle = 0;
+        if (preview != 0) {
+            nativeDestroyProcessor(preview);
+        }
+    }
+
+    /**
+     * Handle del pipeline pedido: "preview" o "measurement" (por defecto)
+     */
+    private long handleForPipeline(String pipeline) {
+        return "preview".equals(pipeline) ? previewHandle : processorHandle;
+    }
+
+    /**
+     * Selección del modo de procesamiento nativo del pipeline de medición
+     * Valores: preview-depth, sparse-measurement, full-reconstruction, calibration-capture
+     */
+    @ReactMethod
+    public void setProcessingMode(String mode, Promise promise) {
+        setPipelineProcessingMode("measurement", mode, promise);
+    }
+
+    /**
+     * Modo de procesamiento de un pipeline concreto ("measurement" o "preview")
+     */
+    @ReactMethod
+    public void setPipelineProcessingMode(String pipeline, String mode, Promise promise) {
+        long handle = handleForPipeline(pipeline);
+        if (handle == 0) {
+            promise.reject("NO_PROCESSOR", "Procesador nativo no inicializado: " + pipeline);
+            return;
+        }
+        
+        int nativeMode;
+        switch (mode) {
+            case "preview-depth": nativeMode = 0; break;
+            case "sparse-measurement": nativeMode = 1; break;
+            case "full-reconstruction": nativeMode = 2; break;
+            case "calibration-capture": nativeMode = 3; break;
+            default:
+                promise.reject("INVALID_MODE", "Modo de procesamiento desconocido: " + mode);
+                return;
+        }
+        
+        nativeSetProcessingMode(handle, nativeMode);
+        promise.resolve(mode);
+    }
+
+    /**
+     * Emparejamiento estéreo de características
+     * Valores: brute-force, disparity-guided (usa la disparidad densa, calcula SGBM si hace falta)
+     */
+    @ReactMethod
+    public void setFeatureMatchMode(String mode, Promise promise) {
+        if (processorHandle == 0) {
+            promise.reject("NO_PROCESSOR", "Procesador nativo no inicializado");
+            return;
+        }
+        
+        int nativeMode;
+        switch (mode) {
+            case "brute-force": nativeMode = 0; break;
+            case "disparity-guided": nativeMode = 1; break;
+            default:
+                promise.reject("INVALID_MODE", "Modo de emparejamiento desconocido: " + mode);
+                return;
+        }
+        
+        nativeSetFeatureMatchMode(processorHandle, nativeMode);
+        promise.resolve(mode);
+    }
+
+    /**
+     * Emparejamiento por fuerza bruta con descriptores PCA int8 (revisión float de candidatos)
+     */
+    @ReactMethod
+    public void setCompactDescriptors(boolean enabled, Promise promise) {
+        if (processorHandle == 0) {
+            promise.reject("NO_PROCESSOR", "Procesador nativo no inicializado");
+            return;
+        }
+        
+        nativeSetCompactDescriptors(processorHandle, enabled);
+        promise.resolve(enabled);
+    }
+
+    /**
+     * Umbrales del filtro de frames movidos: nitidez mínima (varianza del Laplaciano)
+     * y velocidad angular máxima en rad/s; 0 desactiva cada criterio
+     */
+    @ReactMethod
+    public void setSharpnessGate(ReadableMap gate, Promise promise) {
+        if (processorHandle == 0) {
+            promise.reject("NO_PROCESSOR", "Procesador nativo no inicializado");
+            return;
+        }
+        
+        double minSharpness = gate.hasKey("minSharpness") ? gate.getDouble("minSharpness") : 60.0;
+        double maxAngularRate = gate.hasKey("maxAngularRate") ? gate.getDouble("maxAngularRate") : 2.0;
+        
+        nativeSetSharpnessGate(processorHandle, minSharpness, maxAngularRate);
+        promise.resolve(null);
+    }
+
+    /**
+     * Limita la disparidad a las filas de una región (en píxeles rectificados)
+     * Un mapa vacío vuelve al frame completo
+     */
+    @ReactMethod
+    public void setStereoRegion(ReadableMap roi, Promise promise) {
+        if (processorHandle == 0) {
+            promise.reject("NO_PROCESSOR", "Procesador nativo no inicializado");
+            return;
+        }
+        
+        int x = roi.hasKey("x") ? roi.getInt("x") : 0;
+        int y = roi.hasKey("y") ? roi.getInt("y") : 0;
+        int width = roi.hasKey("width") ? roi.getInt("width") : 0;
+        int height = roi.hasKey("height") ? roi.getInt("height") : 0;
+        
+        nativeSetStereoRegion(processorHandle, x, y, width, height);
+        promise.resolve(null);
+    }
+
+    /**
+     * Estadísticas de profundidad en una región del último frame procesado
+     * Consultas repetidas sobre el mismo frame se sirven desde la caché nativa
+     */
+    @ReactMethod
+    public void queryDepthStatistics(ReadableMap roi, Promise promise) {
+        if (processorHandle == 0) {
+            promise.reject("NO_PROCESSOR", "Procesador nativo no inicializado");
+            return;
+        }
+        
+        int x = roi.hasKey("x") ? roi.getInt("x") : 0;
+        int y = roi.hasKey("y") ? roi.getInt("y") : 0;
+        int width = roi.hasKey("width") ? roi.getInt("width") : 0;
+        int height = roi.hasKey("height") ? roi.getInt("height") : 0;
+        
+        double[] stats = nativeQueryDepthStatistics(processorHandle, x, y, width, height);
+        if (stats == null || stats.length < 4) {
+            promise.reject("NO_DEPTH", "Sin datos de profundidad disponibles");
+            return;
+        }
+        
+        WritableMap result = Arguments.createMap();
+        result.putDouble("meanDepth", stats[0]);
+        result.putDouble("stdDepth", stats[1]);
+        result.putDouble("uncertainty95", stats[2]);
+        result.putInt("validPixels", (int) stats[3]);
+        promise.resolve(result);
+    }
+
+    /**
+     * Plano dominante ("horizontal" o "vertical") usando la gravedad de la IMU como priori
+     */
+    @ReactMethod
+    public void detectPlane(String orientation, Promise promise) {
+        if (processorHandle == 0) {
+            promise.reject("NO_PROCESSOR", "Procesador nativo no inicializado");
+            return;
+        }
+        
+        double[] plane = nativeDetectPlane(processorHandle, "vertical".equals(orientation) ? 1 : 0);
+        if (plane == null || plane.length < 6) {
+            promise.reject("NO_PLANE", "Ningún plano detectado con la orientación pedida");
+            return;
+        }
+        
+        WritableMap result = Arguments.createMap();
+        result.putDouble("normalX", plane[0]);
+        result.putDouble("normalY", plane[1]);
+        result.putDouble("normalZ", plane[2]);
+        result.putDouble("distance", Math.abs(plane[3]));
+        result.putInt("inliers", (int) plane[4]);
+        result.putInt("iterations", (int) plane[5]);
+        promise.resolve(result);
+    }
+
+    /**
+     * Profundidad del frame actual en formato compacto (base64), decodificable en JS
+     * con decodeDepthFrame/decodeDepthTile de src/lib/depthStreamDecoder.ts
+     * Opciones: stepMm (0.25), pipeline ("measurement" o "preview")
+     */
+    @ReactMethod
+    public void getDepthFrame(ReadableMap options, Promise promise) {
+        String pipeline = options != null && options.hasKey("pipeline") ? options.getString("pipeline") : "measurement";
+        long handle = handleForPipeline(pipeline);
+        if (handle == 0) {
+            promise.reject("NO_PROCESSOR", "Procesador nativo no inicializado: " + pipeline);
+            return;
+        }
+        
+        double stepMm = options != null && options.hasKey("stepMm") ? options.getDouble("stepMm") : 0.25;
+        if (!(stepMm >= MIN_DEPTH_STEP_MM) || Double.isInfinite(stepMm)) {
+            promise.reject("INVALID_STEP", "stepMm debe ser al menos " + MIN_DEPTH_STEP_MM + " mm (10 m en 16 bits)");
+            return;
+        }
+        byte[] encoded = nativeEncodeDepthFrame(handle, (float) stepMm);
+        if (encoded == null) {
+            promise.reject("NO_DEPTH", "Sin datos de profundidad disponibles");
+            return;
+        }
+        
+        WritableMap result = Arguments.createMap();
+        result.putString("data", Base64.encodeToString(encoded, Base64.NO_WRAP));
+        result.putInt("bytes", encoded.length);
+        promise.resolve(result);
+    }
+
+    /**
+     * Graba los conjuntos de frames de entrada para reprocesarlos offline
+     * Opciones: path (por defecto capture.cmrc en los ficheros de la app), capacityMb (512)
+     */
+    @ReactMethod
+    public void startRecording(ReadableMap options, Promise promise) {
+        if (processorHandle == 0) {
+            promise.reject("NO_PROCESSOR", "Procesador nativo no inicializado");
+            return;
+        }
+        
+        String path = options != null && options.hasKey("path")
+            ? options.getString("path")
+            : new File(reactContext.getExternalFilesDir(null), "capture.cmrc").getAbsolutePath();
+        int capacityMb = options != null && options.hasKey("capacityMb") ? options.getInt("capacityMb") : 512;
+        
+        if (!nativeStartRecording(processorHandle, path, capacityMb)) {
+            promise.reject("RECORDING_ERROR", "No se pudo crear la grabación en " + path);
+            return;
+        }
+        promise.resolve(path);
+    }
+    
+    @ReactMethod
+    public void stopRecording(Promise promise) {
+        if (processorHandle == 0) {
+            promise.reject("NO_PROCESSOR", "Procesador nativo no inicializado");
+            return;
+        }
+        
+        nativeStopRecording(processorHandle);
+        promise.resolve(true);
+    }
+    
+    /**
+     * Reprocesa una grabación por el pipeline nativo; resuelve con los conjuntos reproducidos
+     */
+    @ReactMethod
+    public void replayRecording(String path, Promise promise) {
+        if (processorHandle == 0) {
+            promise.reject("NO_PROCESSOR", "Procesador nativo no inicializado");
+            return;
+        }
+        
+        int replayed = nativeReplayRecording(processorHandle, path);
+        if (replayed < 0) {
+            promise.reject("REPLAY_ERROR", "No se pudo reproducir la grabación " + path);
+            return;
+        }
+        promise.resolve(replayed);
+    }
+
+    /**
+     * Exporta la nube de puntos del frame actual a PLY binario en un hilo propio
+     * Opciones: path, source ("triangulated" | "depth" | "voxels"), colors, confidence, voxelSize (mm)
+     */
+    @ReactMethod
+    public void exportPointCloud(ReadableMap options, Promise promise) {
+        if (processorHandle == 0) {
+            promise.reject("NO_PROCESSOR", "Procesador nativo no inicializado");
+            return;
+        }
+        
+        String path = options != null && options.hasKey("path")
+            ? options.getString("path")
+            : new File(reactContext.getExternalFilesDir(null), "cloud.ply").getAbsolutePath();
+        String sourceName = options != null && options.hasKey("source") ? options.getString("source") : "depth";
+        int source = "triangulated".equals(sourceName) ? 0 : "voxels".equals(sourceName) ? 2 : 1;
+        boolean colors = options == null || !options.hasKey("colors") || options.getBoolean("colors");
+        boolean confidence = options == null || !options.hasKey("confidence") || options.getBoolean("confidence");
+        float voxelSize = options != null && options.hasKey("voxelSize") ? (float) options.getDouble("voxelSize") : 5.0f;
+        final long handle = processorHandle;
+        
+        new Thread(() -> {
+            long points = nativeExportPointCloud(handle, path, source, colors, confidence, voxelSize);
+            if (points < 0) {
+                promise.reject("EXPORT_ERROR", "No se pudo exportar la nube de puntos");
+                return;
+            }
+            WritableMap result = Arguments.createMap();
+            result.putString("path", path);
+            result.putDouble("points", points);
+            promise.resolve(result);
+        }, "PointCloudExport").start();
+    }
+
+    /**
+     * Normal de la superficie en un píxel del mapa de profundidad (marco de la cámara izquierda)
+     */
+    @ReactMethod
+    public void getSurfaceNormal(int x, int y, Promise promise) {
+        if (processorHandle == 0) {
+            promise.reject("NO_PROCESSOR", "Procesador nativo no inicializado");
+            return;
+        }
+        
+        double[] normal = nativeQuerySurfaceNormal(processorHandle, x, y);
+        if (normal == null) {
+            promise.reject("NO_DEPTH", "Sin profundidad fiable en el píxel");
+            return;
+        }
+        
+        WritableMap result = Arguments.createMap();
+        result.putDouble("x", normal[0]);
+        result.putDouble("y", normal[1]);
+        result.putDouble("z", normal[2]);
+        promise.resolve(result);
+    }
+    
+    /**
+     * Malla de la profundidad actual decimada a triangleBudget (por defecto 20000)
+     * vertices: float32 xyz y triangles: int32 en base64 (little-endian)
+     */
+    @ReactMethod
+    public void getMesh(ReadableMap options, Promise promise) {
+        if (processorHandle == 0) {
+            promise.reject("NO_PROCESSOR", "Procesador nativo no inicializado");
+            return;
+        }
+        
+        int triangleBudget = options != null && options.hasKey("triangleBudget") ? options.getInt("triangleBudget") : 20000;
+        byte[][] mesh = nativeGenerateMesh(processorHandle, triangleBudget);
+        if (mesh == null) {
+            promise.reject("NO_DEPTH", "Sin datos de profundidad disponibles");
+            return;
+        }
+        
+        WritableMap result = Arguments.createMap();
+        result.putString("vertices", Base64.encodeToString(mesh[0], Base64.NO_WRAP));
+        result.putString("triangles", Base64.encodeToString(mesh[1], Base64.NO_WRAP));
+        result.putInt("vertexCount", mesh[0].length / 12);
+        result.putInt("triangleCount", mesh[1].length / 12);
+        promise.resolve(result);
+    }
+
+    /**
+     * Calibración con las vistas capturadas en modo calibration-capture
+     * Con una sola cámara configura la corrección de distorsión monocular
+     */
+    @ReactMethod
+    public void runCalibration(Promise promise) {
+        if (processorHandle == 0) {
+            promise.reject("NO_PROCESSOR", "Procesador nativo no inicializado");
+            return;
+        }
+        
+        if (!nativeRunCalibration(processorHandle)) {
+            promise.reject("CALIBRATION_FAILED", "Calibración fallida: vistas insuficientes o error de OpenCV");
+            return;
+        }
+        promise.resolve(null);
+    }
+
+    /**
+     * Plano de referencia para medición monocular (marco de cámara, mm)
+     * { normalX, normalY, normalZ, offset } o { cameraHeight } para el suelo según la gravedad
+     */
+    @ReactMethod
+    public void setReferencePlane(ReadableMap plane, Promise promise) {
+        if (processorHandle == 0) {
+            promise.reject("NO_PROCESSOR", "Procesador nativo no inicializado");
+            return;
+        }
+        
+        double normalX = plane.hasKey("normalX") ? plane.getDouble("normalX") : 0.0;
+        double normalY = plane.hasKey("normalY") ? plane.getDouble("normalY") : 0.0;
+        double normalZ = plane.hasKey("normalZ") ? plane.getDouble("normalZ") : 0.0;
+        double offset = plane.hasKey("offset") ? plane.getDouble("offset") : 0.0;
+        double cameraHeight = plane.hasKey("cameraHeight") ? plane.getDouble("cameraHeight") : 0.0;
+        
+        if (!nativeSetReferencePlane(processorHandle, normalX, normalY, normalZ, offset, cameraHeight)) {
+            promise.reject("NO_GRAVITY", "Sin orientación IMU para el plano de referencia");
+            return;
+        }
+        promise.resolve(null);
+    }
+
+    /**
+     * Puntos 3D sobre el plano de referencia para píxeles [{x, y}, ...] de la imagen capturada
+     * Los píxeles junto a una esquina se ajustan a subpíxel (pixelX/pixelY, refined)
+     * Con dos o más puntos incluye la distancia entre los dos primeros
+     */
+    @ReactMethod
+    public void measureOnReferencePlane(ReadableArray pixels, Promise promise) {
+        if (processorHandle == 0) {
+            promise.reject("NO_PROCESSOR", "Procesador nativo no inicializado");
+            return;
+        }
+        
+        float[] coordinates = new float[pixels.size() * 2];
+        for (int i = 0; i < pixels.size(); i++) {
+            ReadableMap pixel = pixels.getMap(i);
+            coordinates[2 * i] = (float) pixel.getDouble("x");
+            coordinates[2 * i + 1] = (float) pixel.getDouble("y");
+        }
+        
+        double[] values = nativeMeasureOnReferencePlane(processorHandle, coordinates);
+        if (values == null) {
+            promise.reject("NO_REFERENCE", "Sin plano de referencia o sin calibración de la cámara");
+            return;
+        }
+        
+        // Por punto: X, Y, Z, píxel usado (x, y) y si se refinó a subpíxel
+        final int stride = 6;
+        WritableArray points = Arguments.createArray();
+        for (int i = 0; i + stride - 1 < values.length; i += stride) {
+            WritableMap point = Arguments.createMap();
+            point.putDouble("x", values[i]);
+            point.putDouble("y", values[i + 1]);
+            point.putDouble("z", values[i + 2]);
+            point.putDouble("pixelX", values[i + 3]);
+            point.putDouble("pixelY", values[i + 4]);
+            point.putBoolean("refined", values[i + 5] != 0.0);
+            points.pushMap(point);
+        }
+        
+        WritableMap result = Arguments.createMap();
+        result.putArray("points", points);
+        if (values.length >= 2 * stride) {
+            double dx = values[stride] - values[0];
+            double dy = values[stride + 1] - values[1];
+            double dz = values[stride + 2] - values[2];
+            result.putDouble("distance", Math.sqrt(dx * dx + dy * dy + dz * dz));
+        }
+        promise.resolve(result);
+    }
+
     /**
      * Obtención de parámetros exactos de cámara para calibración
      */
@@ -383,7 +891,9 @@ public class MultiCameraModule extends ReactContextBaseJavaModule {
             long timestamp = image.getTimestamp();
             
             // Procesar a través del sistema nativo si todas las cámaras están listas
-            if (isCapturing && isAllCameraDataReady()) {
+            long measurement = processorHandle;
+            long preview = previewHandle;
+            if (isCapturing && measurement != 0 && isAllCameraDataReady()) {
                 byte[][] allFrameData = collectAllFrameData();
                 long[] allTimestamps = collectAllTimestamps();
                 int[] cameraIds = new int[activeCameraCount];
@@ -392,7 +902,10 @@ public class MultiCameraModule extends ReactContextBaseJavaModule {
                 }
                 
                 // Llamada al procesador nativo C++
-                nativeProcessMultiFrame(allFrameData, allTimestamps, cameraIds);
+                nativeProcessMultiFrame(measurement, allFrameData, allTimestamps, cameraIds);
+                if (preview != 0) {
+                    nativeProcessMultiFrame(preview, allFrameData, allTimestamps, cameraIds);
+                }
             }
             
         } catch (Exception e) {
@@ -487,7 +1000,11 @@ public class MultiCameraModule extends ReactContextBaseJavaModule {
         super.onCatalystInstanceDestroy();
         
         // Limpiar recursos nativos
-        nativeCleanup();
+        destroyPreviewHandle();
+        if (processorHandle != 0) {
+            nativeDestroyProcessor(processorHandle);
+            processorHandle = 0;
+        }
         
         // Cerrar cámaras y sesiones
         for (int i = 0; i < MAX_CAMERAS; i++) {
@@ -0,0 +1,116 @@
+/**
+ * CalibrationCache - Parámetros de calibración compartibles entre instancias
+ * Intrínsecos, extrínsecos, mapas de rectificación y matriz Q con versión
+ */
+
+#pragma once
+
+#include "KeypointUndistortGrid.h"
+
+#include <opencv2/calib3d.hpp>
+#include <opencv2/core.hpp>
+#include <array>
+#include <cstdint>
+#include <mutex>
+#include <shared_mutex>
+#include <vector>
+
+struct CalibrationCache {
+    // Escalas de procesamiento: el nivel l trabaja a 1/2^l de la resolución de captura
+    static constexpr int kPyramidLevels = 3;
+
+    // Lectores (procesamiento) con shared_lock, escritores (calibración) con unique_lock
+    mutable std::shared_mutex mutex;
+
+    // Se incrementa en cada calibración para invalidar resultados dependientes
+    uint64_t version = 0;
+
+    cv::Size imageSize;
+
+    // Matrices de calibración para cada cámara
+    std::vector<cv::Mat> cameraMatrices;
+    std::vector<cv::Mat> distortionCoefficients;
+    std::vector<cv::Mat> rotationMatrices;
+    std::vector<cv::Mat> translationVectors;
+
+    // Mapas de rectificación estereoscópica por nivel ([nivel][cámara]): cada nivel muestrea
+    // directamente la fuente a resolución completa, sin remap completo + resize
+    std::array<std::vector<cv::Mat>, kPyramidLevels> rectifyMaps1, rectifyMaps2;
+    std::vector<cv::Mat> rectifyRotations; // R1/R2 de stereoRectify: cámara -> marco rectificado
+    std::vector<cv::Mat> rectifyProjections; // P1/P2 de stereoRectify (nivel 0)
+
+    // Corrección puntual de keypoints detectados en la imagen en bruto (rama de características)
+    std::vector<KeypointUndistortGrid> keypointGrids;
+    cv::Mat Q; // Matriz de disparidad a 3D (resolución completa)
+    std::array<cv::Mat, kPyramidLevels> pyramidQ; // Q en píxeles y disparidades de cada nivel
+
+    static cv::Size levelSize(cv::Size size, int level) {
+        int factor = 1 << level;
+        return cv::Size((size.width + factor - 1) / factor, (size.height + factor - 1) / factor);
+    }
+
+    /**
+     * Mapas de todos los niveles y malla de keypoints para una cámara a partir de R/P de
+     * stereoRectify. El llamador tiene la caché bloqueada en exclusiva
+     */
+    void buildRectifyMaps(int camIdx, const cv::Mat& R, const cv::Mat& P) {
+        rectifyProjections[camIdx] = P.clone();
+        keypointGrids[camIdx].build(cameraMatrices[camIdx], distortionCoefficients[camIdx], R, P, imageSize);
+
+        for (int level = 0; level < kPyramidLevels; level++) {
+            // Centros de píxel: x_l = (x + 0.5)·s - 0.5, así que f' = f·s y c' = (c + 0.5)·s - 0.5
+            double scale = 1.0 / (1 << level);
+            cv::Mat scaledP = P.clone();
+            cv::Mat imageRows = scaledP.rowRange(0, 2);
+            imageRows *= scale;
+            scaledP.at<double>(0, 2) += 0.5 * scale - 0.5;
+            scaledP.at<double>(1, 2) += 0.5 * scale - 0.5;
+
+            cv::initUndistortRectifyMap(cameraMatrices[camIdx], distortionCoefficients[camIdx], R, scaledP,
+                                        levelSize(imageSize, level), CV_16SC2,
+                                        rectifyMaps1[level][camIdx], rectifyMaps2[level][camIdx]);
+        }
+    }
+
+    /**
+     * Q por nivel: Q_l = Q·S, con S llevando (x_l, y_l, d_l, 1) a coordenadas de nivel 0
+     */
+    void setDisparityToDepth(const cv::Mat& disparityToDepth) {
+        Q = disparityToDepth.clone();
+        for (int level = 0; level < kPyramidLevels; level++) {
+            double factor = double(1 << level);
+            double shift = 0.5 * factor - 0.5;
+            cv::Mat S = (cv::Mat_<double>(4, 4) << factor, 0, 0, shift,
+                                                    0, factor, 0, shift,
+                                                    0, 0, factor, 0,
+                                                    0, 0, 0, 1);
+            pyramidQ[level] = Q * S;
+        }
+    }
+
+    /**
+     * Dimensiona la caché para numCameras sin descartar calibraciones existentes. Intrínsecos,
+     * mapas y mallas están en píxeles de imageSize: false si ya se usa a otra resolución (una
+     * instancia de vista previa comparte la resolución de captura y reduce con su nivel)
+     */
+    bool ensureCameraCount(int numCameras, cv::Size size) {
+        std::unique_lock<std::shared_mutex> lock(mutex);
+        if (!imageSize.empty() && imageSize != size) return false;
+        imageSize = size;
+
+        if (static_cast<int>(cameraMatrices.size()) < numCameras) {
+            cameraMatrices.resize(numCameras);
+            distortionCoefficients.resize(numCameras);
+            rotationMatrices.resize(numCameras);
+            translationVectors.resize(numCameras);
+            for (int level = 0; level < kPyramidLevels; level++) {
+                rectifyMaps1[level].resize(numCameras);
+                rectifyMaps2[level].resize(numCameras);
+            }
+            rectifyRotations.resize(numCameras);
+            rectifyProjections.resize(numCameras);
+            keypointGrids.resize(numCameras);
+        }
+        return true;
+    }
+};
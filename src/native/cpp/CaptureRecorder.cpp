@@ -0,0 +1,368 @@
+/**
+ * CaptureRecorder - Implementación del anillo mapeado en memoria y de su lector
+ */
+
+#include "CaptureRecorder.h"
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <iostream>
+
+using namespace std;
+
+namespace {
+
+constexpr uint64_t kPageSize = 4096;
+
+uint64_t alignUp(uint64_t value, uint64_t alignment) {
+    return (value + alignment - 1) / alignment * alignment;
+}
+
+} // namespace
+
+CaptureRecorder::CaptureRecorder() :
+    fileDescriptor(-1),
+    mapping(nullptr),
+    mappingSize(0),
+    stopping(false),
+    writeHead(0),
+    nextSequence(1),
+    recorded(0),
+    dropped(0) {
+}
+
+CaptureRecorder::~CaptureRecorder() {
+    close();
+}
+
+bool CaptureRecorder::open(const string& path, uint64_t capacityBytes, uint32_t indexCapacity) {
+    close();
+    if (capacityBytes == 0 || indexCapacity == 0) return false;
+
+    uint64_t dataOffset = alignUp(kPageSize + uint64_t(indexCapacity) * sizeof(CaptureIndexEntry), kPageSize);
+    uint64_t dataCapacity = alignUp(capacityBytes, kPageSize);
+    uint64_t fileSize = dataOffset + dataCapacity;
+
+    fileDescriptor = ::open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (fileDescriptor < 0) {
+        cerr << "❌ No se pudo crear la grabación: " << path << endl;
+        return false;
+    }
+
+    // Bloques reservados de antemano: la escritura nunca falla por disco lleno a mitad de sesión.
+    // ftruncate (archivo disperso) solo si el sistema de archivos no admite la reserva; con
+    // ENOSPC se falla aquí en vez de con SIGBUS al escribir en el mapeo
+    int allocation = posix_fallocate(fileDescriptor, 0, off_t(fileSize));
+    if (allocation == EOPNOTSUPP || allocation == EINVAL) {
+        allocation = ftruncate(fileDescriptor, off_t(fileSize)) == 0 ? 0 : errno;
+    }
+    if (allocation != 0) {
+        cerr << "❌ No se pudo preasignar " << fileSize << " bytes para la grabación: " << strerror(allocation) << endl;
+        ::close(fileDescriptor);
+        fileDescriptor = -1;
+        return false;
+    }
+
+    void* mapped = mmap(nullptr, size_t(fileSize), PROT_READ | PROT_WRITE, MAP_SHARED, fileDescriptor, 0);
+    if (mapped == MAP_FAILED) {
+        cerr << "❌ No se pudo mapear la grabación en memoria" << endl;
+        ::close(fileDescriptor);
+        fileDescriptor = -1;
+        return false;
+    }
+    mapping = mapped;
+    mappingSize = size_t(fileSize);
+
+    memset(mapping, 0, size_t(dataOffset));
+    CaptureFileHeader* fileHeader = header();
+    memcpy(fileHeader->magic, "CMRC", 4);
+    fileHeader->version = kFileVersion;
+    fileHeader->dataOffset = dataOffset;
+    fileHeader->dataCapacity = dataCapacity;
+    fileHeader->indexCapacity = indexCapacity;
+    fileHeader->committedSequence = 0;
+
+    live.clear();
+    writeHead = 0;
+    nextSequence = 1;
+    recorded.store(0, memory_order_relaxed);
+    dropped.store(0, memory_order_relaxed);
+    stopping = false;
+    writerThread = thread([this] { writerLoop(); });
+
+    cout << "⏺️ Grabación en " << path << " (" << dataCapacity / (1024 * 1024) << " MB, "
+         << indexCapacity << " entradas de índice)" << endl;
+    return true;
+}
+
+void CaptureRecorder::close() {
+    if (mapping == nullptr) return;
+
+    {
+        lock_guard<mutex> lock(queueMutex);
+        stopping = true;
+    }
+    queueCondition.notify_all();
+    if (writerThread.joinable()) {
+        writerThread.join();
+    }
+
+    msync(mapping, mappingSize, MS_SYNC);
+    munmap(mapping, mappingSize);
+    ::close(fileDescriptor);
+    mapping = nullptr;
+    mappingSize = 0;
+    fileDescriptor = -1;
+
+    pending.clear();
+    spare.clear();
+    cout << "⏹️ Grabación cerrada: " << recordedSets() << " conjuntos, " << droppedSets() << " descartados" << endl;
+}
+
+bool CaptureRecorder::submit(const vector<vector<uint8_t>>& frames, const vector<double>& timestamps,
+                             const vector<int>& cameraIds, uint64_t calibrationVersion) {
+    if (mapping == nullptr) return false;
+
+    CapturedFrameSet set;
+    {
+        lock_guard<mutex> lock(queueMutex);
+        if (pending.size() >= kQueueCapacity) {
+            dropped.fetch_add(1, memory_order_relaxed);
+            return false;
+        }
+        if (!spare.empty()) {
+            set = std::move(spare.back());
+            spare.pop_back();
+        }
+    }
+
+    // Copia fuera del lock reutilizando la capacidad de un conjunto ya escrito
+    set.calibrationVersion = calibrationVersion;
+    set.frames.resize(frames.size());
+    for (size_t i = 0; i < frames.size(); i++) {
+        set.frames[i].assign(frames[i].begin(), frames[i].end());
+    }
+    set.timestamps = timestamps;
+    set.cameraIds = cameraIds;
+
+    {
+        lock_guard<mutex> lock(queueMutex);
+        pending.push_back(std::move(set));
+    }
+    queueCondition.notify_one();
+    return true;
+}
+
+void CaptureRecorder::writerLoop() {
+    while (true) {
+        CapturedFrameSet set;
+        {
+            unique_lock<mutex> lock(queueMutex);
+            queueCondition.wait(lock, [this] { return stopping || !pending.empty(); });
+            if (pending.empty()) return; // stopping y cola vacía
+            set = std::move(pending.front());
+            pending.pop_front();
+        }
+
+        writeSet(set);
+
+        lock_guard<mutex> lock(queueMutex);
+        if (spare.size() < kQueueCapacity) {
+            spare.push_back(std::move(set));
+        }
+    }
+}
+
+void CaptureRecorder::releaseRecord(const LiveRecord& record) {
+    CaptureIndexEntry& entry = index()[record.sequence % header()->indexCapacity];
+    if (entry.sequence == record.sequence) {
+        entry.sequence = 0;
+    }
+}
+
+void CaptureRecorder::writeSet(const CapturedFrameSet& set) {
+    CaptureFileHeader* fileHeader = header();
+    const uint32_t frameCount = uint32_t(min(set.frames.size(), min(set.timestamps.size(), set.cameraIds.size())));
+
+    uint64_t payloadBytes = 0;
+    for (uint32_t i = 0; i < frameCount; i++) payloadBytes += set.frames[i].size();
+    uint64_t length = alignUp(sizeof(CaptureRecordHeader) + frameCount * sizeof(CaptureFrameEntry) + payloadBytes, 8);
+    if (length > fileHeader->dataCapacity) {
+        dropped.fetch_add(1, memory_order_relaxed);
+        return;
+    }
+
+    // Sin registros partidos: si no cabe hasta el final se vuelve al inicio y se liberan
+    // los restos de la vuelta anterior (los más antiguos), manteniendo el orden FIFO
+    if (writeHead + length > fileHeader->dataCapacity) {
+        while (!live.empty() && live.front().offset >= writeHead) {
+            releaseRecord(live.front());
+            live.pop_front();
+        }
+        writeHead = 0;
+    }
+
+    // Registros que el nuevo sobrescribe o cuya ranura de índice reutiliza (siempre los más antiguos)
+    while (!live.empty()) {
+        const LiveRecord& oldest = live.front();
+        bool overlaps = oldest.offset >= writeHead && oldest.offset < writeHead + length;
+        if (!overlaps && live.size() < fileHeader->indexCapacity) break;
+        releaseRecord(oldest);
+        live.pop_front();
+    }
+
+    uint64_t sequence = nextSequence++;
+    uint8_t* cursor = data() + writeHead;
+
+    CaptureRecordHeader recordHeader{};
+    memcpy(recordHeader.magic, "FSET", 4);
+    recordHeader.frameCount = frameCount;
+    recordHeader.sequence = sequence;
+    recordHeader.calibrationVersion = set.calibrationVersion;
+    recordHeader.payloadBytes = payloadBytes;
+    memcpy(cursor, &recordHeader, sizeof(recordHeader));
+    cursor += sizeof(recordHeader);
+
+    for (uint32_t i = 0; i < frameCount; i++) {
+        CaptureFrameEntry frameEntry{ int32_t(set.cameraIds[i]), uint32_t(set.frames[i].size()), set.timestamps[i] };
+        memcpy(cursor, &frameEntry, sizeof(frameEntry));
+        cursor += sizeof(frameEntry);
+    }
+    for (uint32_t i = 0; i < frameCount; i++) {
+        if (set.frames[i].empty()) continue;
+        memcpy(cursor, set.frames[i].data(), set.frames[i].size());
+        cursor += set.frames[i].size();
+    }
+
+    // Índice y confirmación después de los datos: un corte deja el registro sin publicar
+    CaptureIndexEntry& entry = index()[sequence % fileHeader->indexCapacity];
+    entry.offset = writeHead;
+    entry.length = uint32_t(length);
+    entry.frameCount = frameCount;
+    entry.timestamp = frameCount > 0 ? set.timestamps[0] : 0.0;
+    atomic_thread_fence(memory_order_release);
+    entry.sequence = sequence;
+    fileHeader->committedSequence = sequence;
+
+    live.push_back({ sequence, writeHead, length });
+    writeHead += length;
+    recorded.fetch_add(1, memory_order_relaxed);
+}
+
+CaptureReader::CaptureReader() :
+    fileDescriptor(-1),
+    mapping(nullptr),
+    mappingSize(0) {
+}
+
+CaptureReader::~CaptureReader() {
+    close();
+}
+
+bool CaptureReader::open(const string& path) {
+    close();
+
+    fileDescriptor = ::open(path.c_str(), O_RDONLY);
+    if (fileDescriptor < 0) return false;
+
+    struct stat info;
+    if (fstat(fileDescriptor, &info) != 0 || uint64_t(info.st_size) < kPageSize) {
+        close();
+        return false;
+    }
+
+    void* mapped = mmap(nullptr, size_t(info.st_size), PROT_READ, MAP_SHARED, fileDescriptor, 0);
+    if (mapped == MAP_FAILED) {
+        close();
+        return false;
+    }
+    mapping = static_cast<const uint8_t*>(mapped);
+    mappingSize = size_t(info.st_size);
+
+    CaptureFileHeader fileHeader;
+    memcpy(&fileHeader, mapping, sizeof(fileHeader));
+    if (memcmp(fileHeader.magic, "CMRC", 4) != 0 || fileHeader.version != CaptureRecorder::kFileVersion ||
+        fileHeader.dataOffset + fileHeader.dataCapacity > mappingSize ||
+        kPageSize + uint64_t(fileHeader.indexCapacity) * sizeof(CaptureIndexEntry) > fileHeader.dataOffset) {
+        cerr << "❌ Grabación con cabecera inválida: " << path << endl;
+        close();
+        return false;
+    }
+
+    // Entradas publicadas cuyo registro sigue intacto, en orden de grabación
+    const uint8_t* dataStart = mapping + fileHeader.dataOffset;
+    for (uint32_t slot = 0; slot < fileHeader.indexCapacity; slot++) {
+        CaptureIndexEntry entry;
+        memcpy(&entry, mapping + kPageSize + slot * sizeof(CaptureIndexEntry), sizeof(entry));
+        if (entry.sequence == 0 || entry.sequence > fileHeader.committedSequence ||
+            entry.offset + entry.length > fileHeader.dataCapacity || entry.length < sizeof(CaptureRecordHeader)) {
+            continue;
+        }
+
+        CaptureRecordHeader recordHeader;
+        memcpy(&recordHeader, dataStart + entry.offset, sizeof(recordHeader));
+        if (memcmp(recordHeader.magic, "FSET", 4) != 0 || recordHeader.sequence != entry.sequence) continue;
+
+        entries.push_back(entry);
+    }
+    sort(entries.begin(), entries.end(), [](const CaptureIndexEntry& a, const CaptureIndexEntry& b) {
+        return a.sequence < b.sequence;
+    });
+
+    // La posición del índice para el lector se guarda como desplazamiento absoluto
+    for (auto& entry : entries) {
+        entry.offset += fileHeader.dataOffset;
+    }
+
+    cout << "▶️ Grabación abierta: " << entries.size() << " conjuntos" << endl;
+    return true;
+}
+
+void CaptureReader::close() {
+    if (mapping != nullptr) {
+        munmap(const_cast<uint8_t*>(mapping), mappingSize);
+    }
+    if (fileDescriptor >= 0) {
+        ::close(fileDescriptor);
+    }
+    mapping = nullptr;
+    mappingSize = 0;
+    fileDescriptor = -1;
+    entries.clear();
+}
+
+bool CaptureReader::read(size_t position, CapturedFrameSet& set) const {
+    if (position >= entries.size()) return false;
+
+    const CaptureIndexEntry& entry = entries[position];
+    const uint8_t* cursor = mapping + entry.offset;
+    const uint8_t* end = cursor + entry.length;
+
+    CaptureRecordHeader recordHeader;
+    memcpy(&recordHeader, cursor, sizeof(recordHeader));
+    cursor += sizeof(recordHeader);
+    if (uint64_t(end - cursor) < uint64_t(recordHeader.frameCount) * sizeof(CaptureFrameEntry)) return false;
+
+    set.sequence = recordHeader.sequence;
+    set.calibrationVersion = recordHeader.calibrationVersion;
+    set.frames.resize(recordHeader.frameCount);
+    set.timestamps.resize(recordHeader.frameCount);
+    set.cameraIds.resize(recordHeader.frameCount);
+
+    const uint8_t* payload = cursor + recordHeader.frameCount * sizeof(CaptureFrameEntry);
+    for (uint32_t i = 0; i < recordHeader.frameCount; i++) {
+        CaptureFrameEntry frameEntry;
+        memcpy(&frameEntry, cursor + i * sizeof(CaptureFrameEntry), sizeof(frameEntry));
+        if (uint64_t(end - payload) < frameEntry.size) return false;
+
+        set.cameraIds[i] = frameEntry.cameraId;
+        set.timestamps[i] = frameEntry.timestamp;
+        set.frames[i].assign(payload, payload + frameEntry.size);
+        payload += frameEntry.size;
+    }
+    return true;
+}
@@ -0,0 +1,173 @@
+/**
+ * CaptureRecorder - Grabación de conjuntos de frames en bruto para reprocesado offline
+ * Anillo en un fichero preasignado y mapeado en memoria, con índice; la escritura ocurre
+ * en un hilo propio y el camino de tiempo real solo copia el conjunto a una cola acotada
+ *
+ * Fichero (little-endian, nativo en ARM/x86):
+ *   [0, 4096)          CaptureFileHeader
+ *   [4096, dataOffset) CaptureIndexEntry[indexCapacity] (ranura = secuencia % capacidad)
+ *   [dataOffset, ...)  anillo de registros: CaptureRecordHeader, CaptureFrameEntry[frameCount],
+ *                      bytes de cada frame, relleno a 8 bytes
+ * Una entrada es válida si su secuencia no es 0, no supera la confirmada en la cabecera y
+ * coincide con la del registro al que apunta
+ */
+
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+struct CaptureFileHeader {
+    char magic[4];              // "CMRC"
+    uint32_t version;
+    uint64_t dataOffset;
+    uint64_t dataCapacity;
+    uint32_t indexCapacity;
+    uint32_t reserved0;
+    uint64_t committedSequence; // Último registro completo (índice incluido)
+    uint64_t reserved[3];
+};
+
+struct CaptureIndexEntry {
+    uint64_t sequence;          // 0 = ranura libre o registro sobrescrito
+    uint64_t offset;            // Relativo a dataOffset
+    uint32_t length;
+    uint32_t frameCount;
+    double timestamp;           // Primer timestamp del conjunto (s)
+};
+
+struct CaptureRecordHeader {
+    char magic[4];              // "FSET"
+    uint32_t frameCount;
+    uint64_t sequence;
+    uint64_t calibrationVersion;
+    uint64_t payloadBytes;
+};
+
+struct CaptureFrameEntry {
+    int32_t cameraId;
+    uint32_t size;
+    double timestamp;           // s, misma base que processMultiFrame
+};
+
+static_assert(sizeof(CaptureFileHeader) == 64, "Cabecera de captura con relleno inesperado");
+static_assert(sizeof(CaptureIndexEntry) == 32, "Entrada de índice con relleno inesperado");
+static_assert(sizeof(CaptureRecordHeader) == 32, "Cabecera de registro con relleno inesperado");
+static_assert(sizeof(CaptureFrameEntry) == 16, "Entrada de frame con relleno inesperado");
+
+/**
+ * Conjunto de frames tal como llegó a processMultiFrame
+ */
+struct CapturedFrameSet {
+    uint64_t sequence = 0;
+    uint64_t calibrationVersion = 0;
+    std::vector<std::vector<uint8_t>> frames;
+    std::vector<double> timestamps;
+    std::vector<int> cameraIds;
+};
+
+class CaptureRecorder {
+public:
+    static constexpr uint32_t kFileVersion = 1;
+    static constexpr uint32_t kDefaultIndexCapacity = 4096;
+    static constexpr size_t kQueueCapacity = 8;
+
+    CaptureRecorder();
+    ~CaptureRecorder();
+
+    CaptureRecorder(const CaptureRecorder&) = delete;
+    CaptureRecorder& operator=(const CaptureRecorder&) = delete;
+
+    /**
+     * Crea (o reemplaza) el fichero con capacityBytes de datos preasignados y arranca el escritor
+     */
+    bool open(const std::string& path, uint64_t capacityBytes, uint32_t indexCapacity = kDefaultIndexCapacity);
+
+    /**
+     * Vacía la cola, sincroniza el fichero y lo cierra
+     */
+    void close();
+
+    bool isOpen() const { return mapping != nullptr; }
+
+    /**
+     * Encola una copia del conjunto; con la cola llena se descarta (nunca bloquea al llamador)
+     */
+    bool submit(const std::vector<std::vector<uint8_t>>& frames, const std::vector<double>& timestamps,
+                const std::vector<int>& cameraIds, uint64_t calibrationVersion);
+
+    uint64_t recordedSets() const { return recorded.load(std::memory_order_relaxed); }
+    uint64_t droppedSets() const { return dropped.load(std::memory_order_relaxed); }
+
+private:
+    struct LiveRecord {
+        uint64_t sequence;
+        uint64_t offset;
+        uint64_t length;
+    };
+
+    void writerLoop();
+    void writeSet(const CapturedFrameSet& set);
+    void releaseRecord(const LiveRecord& record);
+
+    CaptureFileHeader* header() const { return reinterpret_cast<CaptureFileHeader*>(mapping); }
+    CaptureIndexEntry* index() const {
+        return reinterpret_cast<CaptureIndexEntry*>(static_cast<uint8_t*>(mapping) + 4096);
+    }
+    uint8_t* data() const { return static_cast<uint8_t*>(mapping) + header()->dataOffset; }
+
+    // Fichero mapeado
+    int fileDescriptor;
+    void* mapping;
+    size_t mappingSize;
+
+    // Cola acotada hacia el escritor; los conjuntos consumidos vuelven a spare para reutilizar buffers
+    std::mutex queueMutex;
+    std::condition_variable queueCondition;
+    std::deque<CapturedFrameSet> pending;
+    std::vector<CapturedFrameSet> spare;
+    bool stopping;
+    std::thread writerThread;
+
+    // Estado del anillo (solo lo toca el hilo escritor)
+    std::deque<LiveRecord> live;
+    uint64_t writeHead;
+    uint64_t nextSequence;
+
+    std::atomic<uint64_t> recorded;
+    std::atomic<uint64_t> dropped;
+};
+
+/**
+ * Lectura de una grabación (arnés de reproducción): solo lectura, registros por secuencia
+ */
+class CaptureReader {
+public:
+    CaptureReader();
+    ~CaptureReader();
+
+    CaptureReader(const CaptureReader&) = delete;
+    CaptureReader& operator=(const CaptureReader&) = delete;
+
+    bool open(const std::string& path);
+    void close();
+
+    size_t size() const { return entries.size(); }
+
+    /**
+     * Conjunto i-ésimo en orden de grabación (del más antiguo conservado al más reciente)
+     */
+    bool read(size_t position, CapturedFrameSet& set) const;
+
+private:
+    int fileDescriptor;
+    const uint8_t* mapping;
+    size_t mappingSize;
+    std::vector<CaptureIndexEntry> entries;
+};
@@ -0,0 +1,223 @@
+/**
+ * CompactDescriptors - Descriptores SIFT proyectados con PCA a 32 dimensiones y cuantizados a int8
+ * El barrido de fuerza bruta compara 32 bytes por par en lugar de 128 floats (512 bytes):
+ * distancia² ≈ |a|² + |b|² - 2·a·b con producto escalar int8 (VNNI / NEON sdot si el
+ * compilador los habilita). Los mejores candidatos de cada keypoint se vuelven a comparar
+ * con la distancia L2 exacta de los descriptores originales, y se exige validación cruzada
+ */
+
+#pragma once
+
+#include <opencv2/core.hpp>
+#include <opencv2/features2d.hpp>
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+namespace compact_descriptors {
+
+constexpr int kDimensions = 32;             // Un registro de 256 bits por descriptor
+constexpr int kCodeLimit = 127;             // Simétrico: productos por pares caben en int16
+constexpr int kCandidates = 4;              // Candidatos int8 revisados en float
+constexpr int kMinTrainingSamples = 1000;
+
+/**
+ * Producto escalar de dos códigos de kDimensions bytes; sumB = suma de los elementos de b
+ * (corrección del sesgo de VNNI, que multiplica u8 x s8)
+ */
+inline int32_t dot(const int8_t* a, const int8_t* b, int32_t sumB) {
+#if defined(__AVX2__) && ((defined(__AVX512VNNI__) && defined(__AVX512VL__)) || defined(__AVXVNNI__))
+    // a + 128 como u8: Σ(a + 128)·b - 128·Σb
+    __m256i va = _mm256_xor_si256(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(a)),
+                                  _mm256_set1_epi8(char(0x80)));
+    __m256i vb = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(b));
+#if defined(__AVX512VNNI__) && defined(__AVX512VL__)
+    __m256i acc = _mm256_dpbusd_epi32(_mm256_setzero_si256(), va, vb);
+#else
+    __m256i acc = _mm256_dpbusd_avx_epi32(_mm256_setzero_si256(), va, vb);
+#endif
+    __m128i sum = _mm_add_epi32(_mm256_castsi256_si128(acc), _mm256_extracti128_si256(acc, 1));
+    sum = _mm_add_epi32(sum, _mm_shuffle_epi32(sum, _MM_SHUFFLE(1, 0, 3, 2)));
+    sum = _mm_add_epi32(sum, _mm_shuffle_epi32(sum, _MM_SHUFFLE(2, 3, 0, 1)));
+    return _mm_cvtsi128_si32(sum) - 128 * sumB;
+#elif defined(__AVX2__)
+    (void)sumB;
+    __m256i acc = _mm256_setzero_si256();
+    for (int half = 0; half < 2; half++) {
+        __m256i va = _mm256_cvtepi8_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i*>(a + 16 * half)));
+        __m256i vb = _mm256_cvtepi8_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i*>(b + 16 * half)));
+        acc = _mm256_add_epi32(acc, _mm256_madd_epi16(va, vb));
+    }
+    __m128i sum = _mm_add_epi32(_mm256_castsi256_si128(acc), _mm256_extracti128_si256(acc, 1));
+    sum = _mm_add_epi32(sum, _mm_shuffle_epi32(sum, _MM_SHUFFLE(1, 0, 3, 2)));
+    sum = _mm_add_epi32(sum, _mm_shuffle_epi32(sum, _MM_SHUFFLE(2, 3, 0, 1)));
+    return _mm_cvtsi128_si32(sum);
+#elif defined(__ARM_NEON) && defined(__ARM_FEATURE_DOTPROD)
+    (void)sumB;
+    int32x4_t acc = vdotq_s32(vdupq_n_s32(0), vld1q_s8(a), vld1q_s8(b));
+    acc = vdotq_s32(acc, vld1q_s8(a + 16), vld1q_s8(b + 16));
+    return vaddvq_s32(acc);
+#elif defined(__ARM_NEON)
+    (void)sumB;
+    int32x4_t acc = vdupq_n_s32(0);
+    for (int half = 0; half < 2; half++) {
+        int8x16_t va = vld1q_s8(a + 16 * half), vb = vld1q_s8(b + 16 * half);
+        int16x8_t products = vmull_s8(vget_low_s8(va), vget_low_s8(vb));
+        products = vmlal_s8(products, vget_high_s8(va), vget_high_s8(vb)); // |2·127²| < 2^15
+        acc = vpadalq_s16(acc, products);
+    }
+    return vaddvq_s32(acc);
+#else
+    (void)sumB;
+    int32_t sum = 0;
+    for (int i = 0; i < kDimensions; i++) {
+        sum += int32_t(a[i]) * int32_t(b[i]);
+    }
+    return sum;
+#endif
+}
+
+/**
+ * Códigos int8 de un conjunto de descriptores con su norma² y suma de elementos
+ */
+struct CodeSet {
+    std::vector<int8_t> codes;      // count x kDimensions
+    std::vector<int32_t> squaredNorms;
+    std::vector<int32_t> sums;
+
+    int size() const {
+        return int(squaredNorms.size());
+    }
+
+    const int8_t* code(int i) const {
+        return codes.data() + size_t(i) * kDimensions;
+    }
+};
+
+class CompactDescriptorMatcher {
+public:
+    bool hasBasis() const {
+        return !pca.eigenvectors.empty();
+    }
+
+    /**
+     * Base PCA a partir de descriptores de muestra (se calcula una vez y queda fija).
+     * false si hay menos de kMinTrainingSamples
+     */
+    bool train(const cv::Mat& samples) {
+        if (samples.rows < kMinTrainingSamples || samples.type() != CV_32F) return false;
+        pca = cv::PCA(samples, cv::noArray(), cv::PCA::DATA_AS_ROW, kDimensions);
+        return pca.eigenvectors.rows == kDimensions;
+    }
+
+    /**
+     * Emparejamientos mutuos left -> right con distancia L2 exacta (como BFMatcher NORM_L2
+     * con crossCheck); false sin base o con descriptores no CV_32F
+     */
+    bool match(const cv::Mat& left, const cv::Mat& right, std::vector<cv::DMatch>& matches) {
+        matches.clear();
+        if (!hasBasis() || left.type() != CV_32F || right.type() != CV_32F ||
+            left.cols != pca.mean.cols || right.cols != pca.mean.cols) {
+            return false;
+        }
+        if (left.empty() || right.empty()) return true;
+
+        // Escala común a ambos conjuntos: las distancias solo son comparables con el mismo cuanto
+        cv::Mat projectedLeft = pca.project(left), projectedRight = pca.project(right);
+        double lowLeft, highLeft, lowRight, highRight;
+        cv::minMaxIdx(projectedLeft, &lowLeft, &highLeft);
+        cv::minMaxIdx(projectedRight, &lowRight, &highRight);
+        double range = std::max(std::max(-lowLeft, highLeft), std::max(-lowRight, highRight));
+        float scale = float(kCodeLimit / std::max(1e-6, range));
+        quantize(projectedLeft, scale, leftCodes);
+        quantize(projectedRight, scale, rightCodes);
+
+        bestMatches(leftCodes, rightCodes, left, right, forward);
+        bestMatches(rightCodes, leftCodes, right, left, backward);
+
+        for (int i = 0; i < leftCodes.size(); i++) {
+            const cv::DMatch& candidate = forward[i];
+            if (candidate.trainIdx >= 0 && backward[candidate.trainIdx].trainIdx == i) {
+                matches.push_back(candidate);
+            }
+        }
+        return true;
+    }
+
+private:
+    static void quantize(const cv::Mat& projected, float scale, CodeSet& set) {
+        set.codes.resize(size_t(projected.rows) * kDimensions);
+        set.squaredNorms.resize(projected.rows);
+        set.sums.resize(projected.rows);
+        for (int i = 0; i < projected.rows; i++) {
+            const float* source = projected.ptr<float>(i);
+            int8_t* code = set.codes.data() + size_t(i) * kDimensions;
+            int32_t squaredNorm = 0, sum = 0;
+            for (int k = 0; k < kDimensions; k++) {
+                int value = std::min(kCodeLimit, std::max(-kCodeLimit, int(std::lround(source[k] * scale))));
+                code[k] = int8_t(value);
+                squaredNorm += value * value;
+                sum += value;
+            }
+            set.squaredNorms[i] = squaredNorm;
+            set.sums[i] = sum;
+        }
+    }
+
+    /**
+     * Mejor de cada query: barrido int8 completo conservando los kCandidates más cercanos
+     * y elección final con la distancia L2 float de los descriptores originales
+     */
+    static void bestMatches(const CodeSet& queries, const CodeSet& train, const cv::Mat& queryDescriptors,
+                            const cv::Mat& trainDescriptors, std::vector<cv::DMatch>& best) {
+        best.assign(queries.size(), cv::DMatch());
+        for (int q = 0; q < queries.size(); q++) {
+            const int8_t* query = queries.code(q);
+            int32_t candidateDistances[kCandidates];
+            int candidateIndices[kCandidates];
+            int candidates = 0;
+
+            for (int t = 0; t < train.size(); t++) {
+                int32_t distance = queries.squaredNorms[q] + train.squaredNorms[t] -
+                                   2 * dot(query, train.code(t), train.sums[t]);
+                if (candidates == kCandidates && distance >= candidateDistances[kCandidates - 1]) continue;
+
+                // Inserción ordenada en la lista corta de candidatos
+                int slot = std::min(candidates, kCandidates - 1);
+                while (slot > 0 && candidateDistances[slot - 1] > distance) {
+                    candidateDistances[slot] = candidateDistances[slot - 1];
+                    candidateIndices[slot] = candidateIndices[slot - 1];
+                    slot--;
+                }
+                candidateDistances[slot] = distance;
+                candidateIndices[slot] = t;
+                candidates = std::min(candidates + 1, kCandidates);
+            }
+
+            float bestDistance = FLT_MAX;
+            for (int c = 0; c < candidates; c++) {
+                float distance = float(cv::norm(queryDescriptors.row(q), trainDescriptors.row(candidateIndices[c]),
+                                                cv::NORM_L2));
+                if (distance < bestDistance) {
+                    bestDistance = distance;
+                    best[q] = cv::DMatch(q, candidateIndices[c], distance);
+                }
+            }
+        }
+    }
+
+    cv::PCA pca;
+    CodeSet leftCodes, rightCodes;
+    std::vector<cv::DMatch> forward, backward;
+};
+
+} // namespace compact_descriptors
@@ -0,0 +1,163 @@
+/**
+ * DepthIntegralImages - Imágenes integrales del mapa XYZ (X, Y, Z, Z² y píxeles válidos)
+ * Cualquier suma rectangular cuesta 4 accesos. Se construyen solo para las normales por
+ * gradiente 3D medio (~36 B/píxel); las estadísticas de región las reutilizan si ya están
+ * al día para el frame
+ *
+ * Construcción en dos fases paralelizables: sumas por fila (filas independientes) y
+ * acumulación vertical (bloques de columnas independientes). Acumuladores double: en
+ * float el error de cancelación sobre millones de píxeles supera el milímetro
+ */
+
+#pragma once
+
+#include <opencv2/core.hpp>
+
+#include <algorithm>
+#include <cmath>
+
+class DepthIntegralImages {
+public:
+    static constexpr float kMaxDepth = 10000.0f;      // Centinela de reprojectImageTo3D
+    static constexpr float kDiscontinuity = 0.05f;    // Salto relativo de Z por píxel que invalida la normal
+
+    struct WindowSums {
+        cv::Vec3d sum;          // X, Y, Z
+        double sumSquaredZ = 0.0;
+        int count = 0;
+
+        cv::Vec3d mean() const {
+            return count > 0 ? sum * (1.0 / count) : cv::Vec3d();
+        }
+    };
+
+    bool empty() const {
+        return sums.empty();
+    }
+
+    cv::Size size() const {
+        return imageSize;
+    }
+
+    void begin(const cv::Mat& xyz) {
+        points = xyz;
+        imageSize = xyz.size();
+        sums.create(xyz.rows + 1, xyz.cols + 1, CV_64FC4);
+        counts.create(xyz.rows + 1, xyz.cols + 1, CV_32S);
+        sums.row(0).setTo(cv::Scalar::all(0));
+        counts.row(0).setTo(cv::Scalar::all(0));
+    }
+
+    void release() {
+        points.release();
+        sums.release();
+        counts.release();
+        imageSize = cv::Size();
+    }
+
+    /**
+     * Fase 1: suma acumulada de cada fila [rowBegin, rowEnd) de la imagen
+     */
+    void accumulateRows(int rowBegin, int rowEnd) {
+        for (int y = rowBegin; y < rowEnd; y++) {
+            const cv::Vec3f* source = points.ptr<cv::Vec3f>(y);
+            cv::Vec4d* sumRow = sums.ptr<cv::Vec4d>(y + 1);
+            int* countRow = counts.ptr<int>(y + 1);
+
+            cv::Vec4d running(0, 0, 0, 0);
+            int runningCount = 0;
+            sumRow[0] = running;
+            countRow[0] = 0;
+            for (int x = 0; x < imageSize.width; x++) {
+                const cv::Vec3f& p = source[x];
+                if (valid(p)) {
+                    running += cv::Vec4d(p[0], p[1], p[2], double(p[2]) * p[2]);
+                    runningCount++;
+                }
+                sumRow[x + 1] = running;
+                countRow[x + 1] = runningCount;
+            }
+        }
+    }
+
+    /**
+     * Fase 2: acumulación vertical de las columnas [columnBegin, columnEnd) de la integral
+     */
+    void accumulateColumns(int columnBegin, int columnEnd) {
+        for (int y = 1; y <= imageSize.height; y++) {
+            const cv::Vec4d* above = sums.ptr<cv::Vec4d>(y - 1);
+            cv::Vec4d* current = sums.ptr<cv::Vec4d>(y);
+            const int* countAbove = counts.ptr<int>(y - 1);
+            int* countCurrent = counts.ptr<int>(y);
+            for (int x = columnBegin; x < columnEnd; x++) {
+                current[x] += above[x];
+                countCurrent[x] += countAbove[x];
+            }
+        }
+    }
+
+    /**
+     * Sumas de la región (recortada a la imagen)
+     */
+    WindowSums window(cv::Rect region) const {
+        WindowSums result;
+        region &= cv::Rect(0, 0, imageSize.width, imageSize.height);
+        if (region.area() <= 0) return result;
+
+        int x0 = region.x, y0 = region.y, x1 = region.x + region.width, y1 = region.y + region.height;
+        cv::Vec4d s = sums.at<cv::Vec4d>(y1, x1) - sums.at<cv::Vec4d>(y0, x1) -
+                      sums.at<cv::Vec4d>(y1, x0) + sums.at<cv::Vec4d>(y0, x0);
+        result.sum = cv::Vec3d(s[0], s[1], s[2]);
+        result.sumSquaredZ = s[3];
+        result.count = counts.at<int>(y1, x1) - counts.at<int>(y0, x1) - counts.at<int>(y1, x0) + counts.at<int>(y0, x0);
+        return result;
+    }
+
+    /**
+     * Normales por gradiente 3D medio de las filas [rowBegin, rowEnd): diferencia entre las
+     * medias de las semiventanas derecha/izquierda e inferior/superior de radio radius, y
+     * producto vectorial. Número constante de operaciones por píxel; normales orientadas
+     * hacia la cámara, (0,0,0) donde no hay profundidad o la ventana cruza un salto
+     */
+    void estimateNormals(cv::Mat& normals, int radius, int rowBegin, int rowEnd) const {
+        for (int y = rowBegin; y < rowEnd; y++) {
+            const cv::Vec3f* source = points.ptr<cv::Vec3f>(y);
+            cv::Vec3f* target = normals.ptr<cv::Vec3f>(y);
+
+            for (int x = 0; x < imageSize.width; x++) {
+                const cv::Vec3f& p = source[x];
+                target[x] = cv::Vec3f();
+                if (!valid(p)) continue;
+
+                WindowSums right = window(cv::Rect(x + 1, y - radius, radius, 2 * radius + 1));
+                WindowSums left = window(cv::Rect(x - radius, y - radius, radius, 2 * radius + 1));
+                WindowSums bottom = window(cv::Rect(x - radius, y + 1, 2 * radius + 1, radius));
+                WindowSums top = window(cv::Rect(x - radius, y - radius, 2 * radius + 1, radius));
+                if (right.count == 0 || left.count == 0 || bottom.count == 0 || top.count == 0) continue;
+
+                cv::Vec3d horizontal = right.mean() - left.mean();
+                cv::Vec3d vertical = bottom.mean() - top.mean();
+                double maxChange = kDiscontinuity * p[2] * (radius + 1);
+                if (std::abs(horizontal[2]) > maxChange || std::abs(vertical[2]) > maxChange) continue;
+
+                cv::Vec3d normal = vertical.cross(horizontal);
+                double length = cv::norm(normal);
+                if (length <= 0.0) continue;
+
+                normal *= 1.0 / length;
+                if (normal.dot(cv::Vec3d(p[0], p[1], p[2])) > 0.0) normal = -normal;
+                target[x] = cv::Vec3f(float(normal[0]), float(normal[1]), float(normal[2]));
+            }
+        }
+    }
+
+private:
+    static bool valid(const cv::Vec3f& p) {
+        return p[2] > 0.0f && p[2] < kMaxDepth && std::isfinite(p[0]) && std::isfinite(p[1]);
+    }
+
+    cv::Mat points;     // CV_32FC3 de origen (referencia, sin copia)
+    cv::Mat sums;       // CV_64FC4, (alto+1) x (ancho+1)
+    cv::Mat counts;     // CV_32S, (alto+1) x (ancho+1)
+    cv::Size imageSize;
+};
@@ -0,0 +1,351 @@
+/**
+ * DepthMesher - Malla triangular del mapa XYZ con decimación por quadtree
+ * La rejilla de píxeles válidos se triangula sin cruzar saltos de profundidad; cada tesela
+ * de 64x64 celdas es la raíz de un quadtree cuyos nodos se funden en dos triángulos cuando
+ * su Z se desvía poco del parche bilineal de sus esquinas. La tolerancia se elige con un
+ * histograma de errores para acercarse al presupuesto de triángulos
+ *
+ * Fases (las de tesela son independientes y se pueden repartir entre hilos):
+ *   begin -> analyzeTile* -> chooseTolerance -> collectLeaves* -> indexVertices
+ *         -> triangulateTile* -> assemble
+ */
+
+#pragma once
+
+#include <opencv2/core.hpp>
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <initializer_list>
+#include <vector>
+
+struct SurfaceMesh {
+    std::vector<cv::Point3f> vertices;  // Marco rectificado de la cámara izquierda (mm)
+    std::vector<cv::Vec3i> triangles;   // Antihorarios vistos desde la cámara
+
+    void clear() {
+        vertices.clear();
+        triangles.clear();
+    }
+};
+
+class DepthMesher {
+public:
+    static constexpr int kTileSize = 64;            // Potencia de 2: lado del nodo raíz en celdas
+    static constexpr int kLevels = 7;               // Nodos de 1 a 64 celdas de lado
+    static constexpr float kMaxDepth = 10000.0f;    // Centinela de reprojectImageTo3D
+    static constexpr float kDiscontinuity = 0.05f;  // Salto relativo de Z que corta la malla
+
+    // Tolerancias (desviación relativa de Z) en escala logarítmica; el último cubo = no fusionable
+    static constexpr int kToleranceBins = 64;
+    static constexpr float kMinTolerance = 1e-4f;
+    static constexpr float kMaxTolerance = 0.2f;
+
+    void begin(const cv::Mat& xyz) {
+        points = xyz;
+        cellCols = std::max(xyz.cols - 1, 0);
+        cellRows = std::max(xyz.rows - 1, 0);
+        tilesX = (cellCols + kTileSize - 1) / kTileSize;
+        tilesY = (cellRows + kTileSize - 1) / kTileSize;
+        tiles.resize(size_t(tilesX) * tilesY);
+        selectedBin = 0;
+    }
+
+    int tileCount() const {
+        return tilesX * tilesY;
+    }
+
+    float tolerance() const {
+        return binTolerance(selectedBin);
+    }
+
+    /**
+     * Pirámide de errores de la tesela (cubo de tolerancia mínimo para fundir cada nodo)
+     * e histograma de cuántas hojas produciría cada tolerancia
+     */
+    void analyzeTile(int tileIdx) {
+        Tile& tile = tiles[tileIdx];
+        int originX = (tileIdx % tilesX) * kTileSize;
+        int originY = (tileIdx / tilesX) * kTileSize;
+        tile.leafDelta.fill(0);
+
+        std::vector<uint8_t>& cells = tile.bins[0];
+        cells.resize(size_t(kTileSize) * kTileSize);
+        for (int cy = 0; cy < kTileSize; cy++) {
+            for (int cx = 0; cx < kTileSize; cx++) {
+                int x = originX + cx, y = originY + cy;
+                bool usable = x < cellCols && y < cellRows &&
+                              continuous({ depthAt(x, y), depthAt(x + 1, y), depthAt(x, y + 1), depthAt(x + 1, y + 1) });
+                cells[cy * kTileSize + cx] = usable ? 0 : kToleranceBins;
+            }
+        }
+
+        for (int level = 1; level < kLevels; level++) {
+            int side = 1 << level;
+            int nodes = kTileSize >> level;
+            const std::vector<uint8_t>& children = tile.bins[level - 1];
+            std::vector<uint8_t>& parents = tile.bins[level];
+            parents.resize(size_t(nodes) * nodes);
+
+            for (int ny = 0; ny < nodes; ny++) {
+                for (int nx = 0; nx < nodes; nx++) {
+                    int childStride = nodes * 2;
+                    int child = (ny * 2) * childStride + nx * 2;
+                    uint8_t bin = std::max(std::max(children[child], children[child + 1]),
+                                           std::max(children[child + childStride], children[child + childStride + 1]));
+                    if (bin < kToleranceBins) {
+                        bin = std::max(bin, toleranceBin(fitError(originX + nx * side, originY + ny * side, side)));
+                    }
+                    parents[ny * nodes + nx] = bin;
+
+                    // Hijos: hoja para tolerancias entre su cubo y el del padre
+                    for (int c : { child, child + 1, child + childStride, child + childStride + 1 }) {
+                        if (children[c] < bin) {
+                            tile.leafDelta[children[c]]++;
+                            tile.leafDelta[bin]--;
+                        }
+                    }
+                }
+            }
+        }
+
+        // La raíz no tiene padre: es hoja desde su cubo en adelante
+        uint8_t rootBin = tile.bins[kLevels - 1][0];
+        tile.leafDelta[rootBin]++;
+    }
+
+    /**
+     * Menor tolerancia cuyas hojas (2 triángulos cada una) caben en el presupuesto;
+     * presupuesto <= 0 = solo fusiones exactas
+     */
+    void chooseTolerance(int triangleBudget) {
+        selectedBin = 0;
+        if (triangleBudget <= 0) return;
+
+        std::array<int64_t, kToleranceBins + 1> leaves{};
+        for (const Tile& tile : tiles) {
+            for (int bin = 0; bin <= kToleranceBins; bin++) leaves[bin] += tile.leafDelta[bin];
+        }
+
+        int64_t leafCount = 0;
+        for (int bin = 0; bin < kToleranceBins; bin++) {
+            leafCount += leaves[bin];
+            selectedBin = bin;
+            if (2 * leafCount <= triangleBudget) break;
+        }
+    }
+
+    /**
+     * Hojas de la tesela con la tolerancia elegida, más las celdas con 3 esquinas válidas
+     */
+    void collectLeaves(int tileIdx) {
+        Tile& tile = tiles[tileIdx];
+        tile.leaves.clear();
+        tile.partialCells.clear();
+        collectNode(tile, kLevels - 1, 0, 0, (tileIdx % tilesX) * kTileSize, (tileIdx / tilesX) * kTileSize);
+    }
+
+    /**
+     * Índice global de cada esquina de hoja (en serie: las teselas comparten bordes)
+     */
+    void indexVertices() {
+        vertexIds.create(points.size(), CV_32S);
+        vertexIds.setTo(-1);
+        vertices.clear();
+
+        for (const Tile& tile : tiles) {
+            for (const cv::Vec3i& leaf : tile.leaves) {
+                int x = leaf[0], y = leaf[1], side = leaf[2];
+                addVertex(x, y);
+                addVertex(x + side, y);
+                addVertex(x, y + side);
+                addVertex(x + side, y + side);
+            }
+            for (const cv::Vec3i& cell : tile.partialCells) {
+                for (int corner = 0; corner < 4; corner++) {
+                    if (corner != cell[2]) addVertex(cell[0] + (corner & 1), cell[1] + (corner >> 1));
+                }
+            }
+        }
+    }
+
+    /**
+     * Triángulos de la tesela. Una hoja con vértices de hojas vecinas más pequeñas en su
+     * borde se triangula en abanico desde su centro, sin grietas en las uniones en T
+     */
+    void triangulateTile(int tileIdx) {
+        Tile& tile = tiles[tileIdx];
+        tile.triangles.clear();
+        tile.centers.clear();
+
+        std::vector<int> ring;
+        for (const cv::Vec3i& leaf : tile.leaves) {
+            int x = leaf[0], y = leaf[1], side = leaf[2];
+            int topLeft = vertexIds.at<int>(y, x), topRight = vertexIds.at<int>(y, x + side);
+            int bottomLeft = vertexIds.at<int>(y + side, x), bottomRight = vertexIds.at<int>(y + side, x + side);
+
+            ring.clear();
+            if (side > 1) collectRing(x, y, side, ring);
+
+            if (ring.size() <= 4) {
+                tile.triangles.emplace_back(topLeft, bottomLeft, topRight);
+                tile.triangles.emplace_back(topRight, bottomLeft, bottomRight);
+                continue;
+            }
+
+            // Centro propio de la hoja: índice local negativo hasta assemble
+            tile.centers.emplace_back(x + side / 2, y + side / 2);
+            int center = -int(tile.centers.size());
+            for (size_t i = 0; i < ring.size(); i++) {
+                tile.triangles.emplace_back(center, ring[(i + 1) % ring.size()], ring[i]);
+            }
+        }
+
+        // Celdas parciales: el triángulo opuesto a la esquina inválida
+        for (const cv::Vec3i& cell : tile.partialCells) {
+            int x = cell[0], y = cell[1];
+            int a = vertexIds.at<int>(y, x), b = vertexIds.at<int>(y, x + 1);
+            int c = vertexIds.at<int>(y + 1, x), d = vertexIds.at<int>(y + 1, x + 1);
+            switch (cell[2]) {
+                case 0: tile.triangles.emplace_back(b, c, d); break;
+                case 1: tile.triangles.emplace_back(a, c, d); break;
+                case 2: tile.triangles.emplace_back(a, d, b); break;
+                default: tile.triangles.emplace_back(a, c, b); break;
+            }
+        }
+    }
+
+    void assemble(SurfaceMesh& mesh) {
+        mesh.vertices.swap(vertices);
+        mesh.triangles.clear();
+
+        for (const Tile& tile : tiles) {
+            int centerBase = int(mesh.vertices.size());
+            for (const cv::Point& center : tile.centers) {
+                mesh.vertices.push_back(points.at<cv::Point3f>(center.y, center.x));
+            }
+            for (cv::Vec3i triangle : tile.triangles) {
+                for (int k = 0; k < 3; k++) {
+                    if (triangle[k] < 0) triangle[k] = centerBase - triangle[k] - 1;
+                }
+                mesh.triangles.push_back(triangle);
+            }
+        }
+    }
+
+private:
+    struct Tile {
+        std::array<std::vector<uint8_t>, kLevels> bins;       // Cubo de cada nodo por nivel
+        std::array<int64_t, kToleranceBins + 1> leafDelta{};  // Hojas que entran/salen en cada cubo
+        std::vector<cv::Vec3i> leaves;                        // x, y (vértice superior izquierdo), lado
+        std::vector<cv::Vec3i> partialCells;                  // x, y, esquina inválida (0..3)
+        std::vector<cv::Vec3i> triangles;
+        std::vector<cv::Point> centers;
+    };
+
+    float depthAt(int x, int y) const {
+        float z = points.at<cv::Point3f>(y, x).z;
+        return z > 0.0f && z < kMaxDepth ? z : 0.0f;
+    }
+
+    static bool continuous(std::initializer_list<float> depths) {
+        float minDepth = std::min(depths), maxDepth = std::max(depths);
+        return minDepth > 0.0f && maxDepth - minDepth <= kDiscontinuity * minDepth;
+    }
+
+    static float binTolerance(int bin) {
+        if (bin <= 0) return 0.0f;
+        float ratio = std::log(kMaxTolerance / kMinTolerance) / float(kToleranceBins - 2);
+        return kMinTolerance * std::exp(ratio * float(bin - 1));
+    }
+
+    static uint8_t toleranceBin(float error) {
+        if (error <= 0.0f) return 0;
+        if (!(error <= kMaxTolerance)) return kToleranceBins;
+        float ratio = std::log(kMaxTolerance / kMinTolerance) / float(kToleranceBins - 2);
+        int bin = 1 + int(std::ceil(std::log(std::max(error, kMinTolerance) / kMinTolerance) / ratio));
+        return uint8_t(std::min(bin, kToleranceBins - 1));
+    }
+
+    /**
+     * Máxima desviación relativa de Z respecto al parche bilineal de las 4 esquinas
+     */
+    float fitError(int x, int y, int side) const {
+        float z00 = depthAt(x, y), z10 = depthAt(x + side, y);
+        float z01 = depthAt(x, y + side), z11 = depthAt(x + side, y + side);
+        float inverseSide = 1.0f / side;
+        float worst = 0.0f;
+
+        for (int j = 0; j <= side; j++) {
+            float v = j * inverseSide;
+            float left = z00 + (z01 - z00) * v;
+            float right = z10 + (z11 - z10) * v;
+            const cv::Point3f* row = points.ptr<cv::Point3f>(y + j) + x;
+            for (int i = 0; i <= side; i++) {
+                float expected = left + (right - left) * (i * inverseSide);
+                worst = std::max(worst, std::abs(row[i].z - expected) / expected);
+            }
+        }
+        return worst;
+    }
+
+    void collectNode(Tile& tile, int level, int nx, int ny, int originX, int originY) {
+        int nodes = kTileSize >> level;
+        int side = 1 << level;
+        int x = originX + nx * side, y = originY + ny * side;
+        if (x >= cellCols || y >= cellRows) return;
+
+        if (tile.bins[level][ny * nodes + nx] <= selectedBin) {
+            tile.leaves.emplace_back(x, y, side);
+            return;
+        }
+
+        if (level == 0) {
+            // Celda con una sola esquina inválida o discontinua: se conserva el triángulo continuo
+            float depths[4] = { depthAt(x, y), depthAt(x + 1, y), depthAt(x, y + 1), depthAt(x + 1, y + 1) };
+            for (int missing = 0; missing < 4; missing++) {
+                float a = depths[(missing + 1) & 3], b = depths[(missing + 2) & 3], c = depths[(missing + 3) & 3];
+                if (continuous({ a, b, c })) {
+                    tile.partialCells.emplace_back(x, y, missing);
+                    return;
+                }
+            }
+            return;
+        }
+
+        for (int child = 0; child < 4; child++) {
+            collectNode(tile, level - 1, nx * 2 + (child & 1), ny * 2 + (child >> 1), originX, originY);
+        }
+    }
+
+    void addVertex(int x, int y) {
+        int& id = vertexIds.at<int>(y, x);
+        if (id >= 0) return;
+        id = int(vertices.size());
+        vertices.push_back(points.at<cv::Point3f>(y, x));
+    }
+
+    /**
+     * Vértices ya indexados del borde de la hoja, en sentido horario desde la esquina superior izquierda
+     */
+    void collectRing(int x, int y, int side, std::vector<int>& ring) const {
+        auto visit = [&](int px, int py) {
+            int id = vertexIds.at<int>(py, px);
+            if (id >= 0) ring.push_back(id);
+        };
+        for (int i = 0; i < side; i++) visit(x + i, y);
+        for (int i = 0; i < side; i++) visit(x + side, y + i);
+        for (int i = side; i > 0; i--) visit(x + i, y + side);
+        for (int i = side; i > 0; i--) visit(x, y + i);
+    }
+
+    cv::Mat points;     // CV_32FC3
+    cv::Mat vertexIds;  // CV_32S, -1 = sin vértice
+    std::vector<cv::Point3f> vertices;
+    std::vector<Tile> tiles;
+    int cellCols = 0, cellRows = 0;
+    int tilesX = 0, tilesY = 0;
+    int selectedBin = 0;
+};
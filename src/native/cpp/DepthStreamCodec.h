@@ -0,0 +1,392 @@
+/**
+ * DepthStreamCodec - Formato compacto de profundidad para enviar al puente JS
+ * Profundidad cuantizada a 16 bits + máscara de validez, por teselas independientes
+ * (acceso aleatorio), con predicción delta por fila y códigos Rice como etapa entrópica
+ *
+ * Formato (little-endian):
+ *   Cabecera (24 bytes): "CMDS", u8 versión, u8 reservado, u16 tamaño de tesela,
+ *                        u16 ancho, u16 alto, f32 paso (mm por unidad), u32 teselas, u32 reservado
+ *   Tabla: u32 offsets[teselas + 1] relativos al inicio de los datos de teselas
+ *   Tesela: u8 modo de máscara (0 sin válidos, 1 todos válidos, 2 mapa de bits) [+ mapa de bits],
+ *           flujo de bits LSB primero: por fila, k en 4 bits y los residuos Rice de sus válidos
+ */
+
+#pragma once
+
+#include <opencv2/core.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+namespace depth_stream {
+
+constexpr uint8_t kVersion = 1;
+constexpr size_t kHeaderSize = 24;
+constexpr int kDefaultTileSize = 64;
+constexpr float kMaxDepthMm = 10000.0f; // Centinela de reprojectImageTo3D
+constexpr float kMinStepMm = kMaxDepthMm / 65535.0f; // Paso mínimo: todo (0, kMaxDepthMm) cabe en 16 bits
+
+// Cociente unario máximo antes de escapar al valor residual en bruto (17 bits)
+constexpr int kRiceEscape = 24;
+constexpr int kRawResidualBits = 17;
+
+enum MaskMode : uint8_t {
+    MaskNone = 0,
+    MaskAll = 1,
+    MaskBitmap = 2
+};
+
+struct DepthStreamInfo {
+    int width = 0;
+    int height = 0;
+    int tileSize = 0;
+    int tilesX = 0;
+    int tilesY = 0;
+    float stepMm = 1.0f;
+};
+
+class BitWriter {
+public:
+    explicit BitWriter(std::vector<uint8_t>& output) : out(output) {}
+
+    void write(uint32_t value, int bits) {
+        accumulator |= uint64_t(value) << pending;
+        pending += bits;
+        while (pending >= 8) {
+            out.push_back(uint8_t(accumulator));
+            accumulator >>= 8;
+            pending -= 8;
+        }
+    }
+
+    void writeOnes(int count) {
+        while (count > 0) {
+            int chunk = std::min(count, 24);
+            write((1u << chunk) - 1, chunk);
+            count -= chunk;
+        }
+    }
+
+    void flush() {
+        if (pending > 0) out.push_back(uint8_t(accumulator));
+        accumulator = 0;
+        pending = 0;
+    }
+
+private:
+    std::vector<uint8_t>& out;
+    uint64_t accumulator = 0;
+    int pending = 0;
+};
+
+class BitReader {
+public:
+    BitReader(const uint8_t* data, size_t size) : cursor(data), end(data + size), totalBits(8 * size) {}
+
+    uint32_t read(int bits) {
+        refill();
+        uint32_t value = uint32_t(accumulator & ((uint64_t(1) << bits) - 1));
+        accumulator >>= bits;
+        available -= bits;
+        consumedBits += bits;
+        return value;
+    }
+
+    /**
+     * Unos consecutivos hasta un cero (consumido) o hasta limit (sin terminador)
+     */
+    int readUnary(int limit) {
+        int count = 0;
+        while (count < limit) {
+            if (read(1) == 0) return count;
+            count++;
+        }
+        return count;
+    }
+
+    /**
+     * Flujo truncado: se leyeron más bits de los disponibles (rellenados con ceros)
+     */
+    bool overrun() const {
+        return consumedBits > totalBits;
+    }
+
+private:
+    void refill() {
+        while (available <= 56) {
+            uint64_t byte = cursor < end ? *cursor++ : 0;
+            accumulator |= byte << available;
+            available += 8;
+        }
+    }
+
+    const uint8_t* cursor;
+    const uint8_t* end;
+    uint64_t accumulator = 0;
+    int available = 0;
+    size_t consumedBits = 0;
+    size_t totalBits;
+};
+
+inline uint32_t zigzag(int32_t value) {
+    return (uint32_t(value) << 1) ^ uint32_t(value >> 31);
+}
+
+inline int32_t unzigzag(uint32_t value) {
+    return int32_t(value >> 1) ^ -int32_t(value & 1);
+}
+
+inline void writeU16(std::vector<uint8_t>& out, size_t at, uint16_t value) {
+    out[at] = uint8_t(value);
+    out[at + 1] = uint8_t(value >> 8);
+}
+
+inline void writeU32(std::vector<uint8_t>& out, size_t at, uint32_t value) {
+    for (int i = 0; i < 4; i++) out[at + i] = uint8_t(value >> (8 * i));
+}
+
+inline uint16_t readU16(const uint8_t* data) {
+    return uint16_t(data[0] | (data[1] << 8));
+}
+
+inline uint32_t readU32(const uint8_t* data) {
+    return uint32_t(data[0]) | (uint32_t(data[1]) << 8) | (uint32_t(data[2]) << 16) | (uint32_t(data[3]) << 24);
+}
+
+/**
+ * Parámetro Rice de una fila: el mayor k con 2^k <= media de los residuos
+ */
+inline int riceParameter(const uint32_t* residuals, int count) {
+    if (count == 0) return 0;
+    uint64_t sum = 0;
+    for (int i = 0; i < count; i++) sum += residuals[i];
+    int k = 0;
+    while (k < 15 && (uint64_t(count) << (k + 1)) <= sum) k++;
+    return k;
+}
+
+/**
+ * Codifica una tesela ya cuantizada (0 = inválido) a continuación de out
+ */
+inline void encodeTile(const uint16_t* quantized, size_t stride, int width, int height, std::vector<uint8_t>& out) {
+    int validCount = 0;
+    for (int y = 0; y < height; y++) {
+        for (int x = 0; x < width; x++) validCount += quantized[y * stride + x] != 0;
+    }
+
+    if (validCount == 0) {
+        out.push_back(MaskNone);
+        return;
+    }
+    if (validCount == width * height) {
+        out.push_back(MaskAll);
+    } else {
+        out.push_back(MaskBitmap);
+        size_t maskStart = out.size();
+        out.resize(maskStart + (size_t(width) * height + 7) / 8, 0);
+        for (int y = 0; y < height; y++) {
+            for (int x = 0; x < width; x++) {
+                if (quantized[y * stride + x] == 0) continue;
+                size_t bit = size_t(y) * width + x;
+                out[maskStart + bit / 8] |= uint8_t(1u << (bit % 8));
+            }
+        }
+    }
+
+    BitWriter writer(out);
+    std::vector<uint32_t> residuals(width);
+    int32_t rowStart = 0; // Primer válido de la fila anterior: predicción del primero de esta
+
+    for (int y = 0; y < height; y++) {
+        const uint16_t* row = quantized + y * stride;
+        int count = 0;
+        int32_t previous = rowStart;
+        bool first = true;
+        for (int x = 0; x < width; x++) {
+            if (row[x] == 0) continue;
+            residuals[count++] = zigzag(int32_t(row[x]) - previous);
+            if (first) {
+                rowStart = row[x];
+                first = false;
+            }
+            previous = row[x];
+        }
+
+        int k = riceParameter(residuals.data(), count);
+        writer.write(uint32_t(k), 4);
+        for (int i = 0; i < count; i++) {
+            uint32_t quotient = residuals[i] >> k;
+            if (quotient < uint32_t(kRiceEscape)) {
+                writer.writeOnes(int(quotient));
+                writer.write(0, 1);
+                if (k > 0) writer.write(residuals[i] & ((1u << k) - 1), k);
+            } else {
+                writer.writeOnes(kRiceEscape);
+                writer.write(residuals[i], kRawResidualBits);
+            }
+        }
+    }
+    writer.flush();
+}
+
+/**
+ * Profundidad Z (mm, stride en floats) -> flujo compacto. Fuera de (0, kMaxDepthMm) o no finito = inválido
+ */
+inline void encodeDepthFrame(const float* depth, size_t stride, int width, int height, float stepMm,
+                             std::vector<uint8_t>& out, int tileSize = kDefaultTileSize) {
+    const int tilesX = (width + tileSize - 1) / tileSize;
+    const int tilesY = (height + tileSize - 1) / tileSize;
+    const uint32_t tileCount = uint32_t(tilesX) * tilesY;
+
+    // Cuantización: 1..65535 unidades de stepMm, 0 reservado para inválido (también lo que no
+    // cabe en 16 bits: con stepMm < kMinStepMm se perdería en vez de saturar a 65535·stepMm)
+    std::vector<uint16_t> quantized(size_t(width) * height);
+    const float inverseStep = 1.0f / stepMm;
+    for (int y = 0; y < height; y++) {
+        const float* row = depth + size_t(y) * stride;
+        uint16_t* target = quantized.data() + size_t(y) * width;
+        for (int x = 0; x < width; x++) {
+            float z = row[x];
+            float units = std::round(z * inverseStep);
+            bool valid = std::isfinite(z) && z > 0.0f && z < kMaxDepthMm && units <= 65535.0f;
+            units = valid ? std::max(units, 1.0f) : 0.0f;
+            target[x] = uint16_t(units);
+        }
+    }
+
+    out.clear();
+    out.resize(kHeaderSize + 4 * (size_t(tileCount) + 1), 0);
+    std::memcpy(out.data(), "CMDS", 4);
+    out[4] = kVersion;
+    writeU16(out, 6, uint16_t(tileSize));
+    writeU16(out, 8, uint16_t(width));
+    writeU16(out, 10, uint16_t(height));
+    uint32_t stepBits;
+    std::memcpy(&stepBits, &stepMm, 4);
+    writeU32(out, 12, stepBits);
+    writeU32(out, 16, tileCount);
+
+    const size_t tableStart = kHeaderSize;
+    const size_t payloadStart = out.size();
+    for (int ty = 0; ty < tilesY; ty++) {
+        for (int tx = 0; tx < tilesX; tx++) {
+            uint32_t index = uint32_t(ty) * tilesX + tx;
+            writeU32(out, tableStart + 4 * index, uint32_t(out.size() - payloadStart));
+            int x0 = tx * tileSize, y0 = ty * tileSize;
+            encodeTile(quantized.data() + size_t(y0) * width + x0, size_t(width),
+                       std::min(tileSize, width - x0), std::min(tileSize, height - y0), out);
+        }
+    }
+    writeU32(out, tableStart + 4 * size_t(tileCount), uint32_t(out.size() - payloadStart));
+}
+
+inline void encodeDepthFrame(const cv::Mat& depthZ, float stepMm, std::vector<uint8_t>& out,
+                             int tileSize = kDefaultTileSize) {
+    CV_Assert(depthZ.type() == CV_32FC1 && std::isfinite(stepMm) && stepMm >= kMinStepMm);
+    encodeDepthFrame(depthZ.ptr<float>(0), depthZ.step / sizeof(float), depthZ.cols, depthZ.rows, stepMm, out, tileSize);
+}
+
+/**
+ * Lectura y validación de la cabecera
+ */
+inline bool readDepthStreamInfo(const uint8_t* data, size_t size, DepthStreamInfo& info) {
+    if (size < kHeaderSize || std::memcmp(data, "CMDS", 4) != 0 || data[4] != kVersion) return false;
+
+    info.tileSize = readU16(data + 6);
+    info.width = readU16(data + 8);
+    info.height = readU16(data + 10);
+    uint32_t stepBits = readU32(data + 12);
+    std::memcpy(&info.stepMm, &stepBits, 4);
+    if (info.tileSize <= 0) return false;
+
+    info.tilesX = (info.width + info.tileSize - 1) / info.tileSize;
+    info.tilesY = (info.height + info.tileSize - 1) / info.tileSize;
+    return readU32(data + 16) == uint32_t(info.tilesX) * info.tilesY &&
+           size >= kHeaderSize + 4 * (size_t(info.tilesX) * info.tilesY + 1);
+}
+
+/**
+ * Decodificador de referencia de una tesela: escribe mm en depth (stride en floats), NaN si inválido
+ */
+inline bool decodeDepthTile(const uint8_t* data, size_t size, int tileIndex, float* depth, size_t stride) {
+    DepthStreamInfo info;
+    if (!readDepthStreamInfo(data, size, info) || tileIndex < 0 || tileIndex >= info.tilesX * info.tilesY) return false;
+
+    const size_t payloadStart = kHeaderSize + 4 * (size_t(info.tilesX) * info.tilesY + 1);
+    const size_t begin = payloadStart + readU32(data + kHeaderSize + 4 * size_t(tileIndex));
+    const size_t end = payloadStart + readU32(data + kHeaderSize + 4 * size_t(tileIndex + 1));
+    if (begin >= end || end > size) return false;
+
+    const int tx = tileIndex % info.tilesX, ty = tileIndex / info.tilesX;
+    const int width = std::min(info.tileSize, info.width - tx * info.tileSize);
+    const int height = std::min(info.tileSize, info.height - ty * info.tileSize);
+
+    const uint8_t* cursor = data + begin;
+    const uint8_t mode = *cursor++;
+    const uint8_t* mask = nullptr;
+    if (mode == MaskNone) {
+        for (int y = 0; y < height; y++) std::fill(depth + y * stride, depth + y * stride + width, NAN);
+        return true;
+    }
+    if (mode == MaskBitmap) {
+        mask = cursor;
+        cursor += (size_t(width) * height + 7) / 8;
+    } else if (mode != MaskAll) {
+        return false;
+    }
+    if (cursor > data + end) return false;
+
+    BitReader reader(cursor, size_t(data + end - cursor));
+    int32_t rowStart = 0;
+    for (int y = 0; y < height; y++) {
+        float* row = depth + y * stride;
+        int k = int(reader.read(4));
+        int32_t previous = rowStart;
+        bool first = true;
+        for (int x = 0; x < width; x++) {
+            size_t bit = size_t(y) * width + x;
+            if (mask != nullptr && !(mask[bit / 8] & (1u << (bit % 8)))) {
+                row[x] = NAN;
+                continue;
+            }
+
+            uint32_t residual;
+            int quotient = reader.readUnary(kRiceEscape);
+            if (quotient < kRiceEscape) {
+                residual = (uint32_t(quotient) << k) | (k > 0 ? reader.read(k) : 0);
+            } else {
+                residual = reader.read(kRawResidualBits);
+            }
+
+            int32_t value = previous + unzigzag(residual);
+            if (first) {
+                rowStart = value;
+                first = false;
+            }
+            previous = value;
+            row[x] = float(value) * info.stepMm;
+        }
+    }
+    return !reader.overrun();
+}
+
+/**
+ * Decodificador de referencia del frame completo (mm, NaN si inválido) en un buffer de info.width·info.height
+ */
+inline bool decodeDepthFrame(const uint8_t* data, size_t size, std::vector<float>& depth, DepthStreamInfo& info) {
+    if (!readDepthStreamInfo(data, size, info)) return false;
+
+    depth.resize(size_t(info.width) * info.height);
+    for (int ty = 0; ty < info.tilesY; ty++) {
+        for (int tx = 0; tx < info.tilesX; tx++) {
+            float* origin = depth.data() + size_t(ty) * info.tileSize * info.width + size_t(tx) * info.tileSize;
+            if (!decodeDepthTile(data, size, ty * info.tilesX + tx, origin, size_t(info.width))) return false;
+        }
+    }
+    return true;
+}
+
+} // namespace depth_stream
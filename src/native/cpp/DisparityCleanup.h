@@ -0,0 +1,204 @@
+/**
+ * DisparityCleanup - Filtrado de motas y relleno de huecos pequeños de la disparidad CV_16S
+ * Motas: componentes conexas (4-vecindad, |Δd| <= maxDifference) de hasta maxSpeckleSize
+ * píxeles pasan a inválido, como filterSpeckles, pero por franjas de filas en paralelo:
+ * union-find local por franja, unión en serie solo de las filas frontera y borrado por
+ * franja con búsquedas de solo lectura
+ *
+ * Huecos: barrido por filas y después por columnas de los tramos inválidos de hasta
+ * maxWidth píxeles con vecinos válidos a ambos lados. Extremos de la misma superficie se
+ * interpolan; si no, se rellena con la disparidad menor (el fondo) para no engordar bordes
+ */
+
+#pragma once
+
+#include <opencv2/core.hpp>
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <vector>
+
+class SpeckleFilter {
+public:
+    static constexpr int kBandRows = 32;
+
+    void begin(cv::Mat& disparity, short invalid, int maxSpeckleSize, int maxDifference) {
+        map = disparity;
+        invalidValue = invalid;
+        maxSize = maxSpeckleSize;
+        maxDiff = maxDifference;
+
+        size_t pixels = size_t(map.rows) * map.cols;
+        parent.resize(pixels);
+        componentSize.resize(pixels);
+        removedPerBand.assign(bandCount(), 0);
+    }
+
+    int bandCount() const {
+        return (map.rows + kBandRows - 1) / kBandRows;
+    }
+
+    /**
+     * Fase 1: componentes de la franja (solo enlaza píxeles de la propia franja)
+     */
+    void labelBand(int band) {
+        const int width = map.cols;
+        int rowBegin = band * kBandRows, rowEnd = std::min(map.rows, rowBegin + kBandRows);
+        for (int y = rowBegin; y < rowEnd; y++) {
+            const short* row = map.ptr<short>(y);
+            const short* above = y > rowBegin ? map.ptr<short>(y - 1) : nullptr;
+            int32_t index = int32_t(size_t(y) * width);
+            for (int x = 0; x < width; x++, index++) {
+                if (row[x] <= invalidValue) {
+                    parent[index] = -1;
+                    continue;
+                }
+                parent[index] = index;
+                componentSize[index] = 1;
+                if (x > 0 && row[x - 1] > invalidValue && connected(row[x], row[x - 1])) unite(index, index - 1);
+                if (above != nullptr && above[x] > invalidValue && connected(row[x], above[x])) {
+                    unite(index, index - width);
+                }
+            }
+        }
+    }
+
+    /**
+     * Fase 2 (en serie): une cada franja con la anterior a través de su primera fila
+     */
+    void mergeBands() {
+        const int width = map.cols;
+        for (int band = 1; band < bandCount(); band++) {
+            int y = band * kBandRows;
+            const short* row = map.ptr<short>(y);
+            const short* above = map.ptr<short>(y - 1);
+            int32_t index = int32_t(size_t(y) * width);
+            for (int x = 0; x < width; x++, index++) {
+                if (row[x] > invalidValue && above[x] > invalidValue && connected(row[x], above[x])) {
+                    unite(index, index - width);
+                }
+            }
+        }
+    }
+
+    /**
+     * Fase 3: invalida los píxeles de la franja cuyas componentes son motas
+     */
+    void removeBand(int band) {
+        const int width = map.cols;
+        int rowBegin = band * kBandRows, rowEnd = std::min(map.rows, rowBegin + kBandRows);
+        int removed = 0;
+        for (int y = rowBegin; y < rowEnd; y++) {
+            short* row = map.ptr<short>(y);
+            int32_t index = int32_t(size_t(y) * width);
+            for (int x = 0; x < width; x++, index++) {
+                if (parent[index] < 0 || componentSize[findRoot(index)] > maxSize) continue;
+                row[x] = invalidValue;
+                removed++;
+            }
+        }
+        removedPerBand[band] = removed;
+    }
+
+    int removedPixels() const {
+        int total = 0;
+        for (int removed : removedPerBand) total += removed;
+        return total;
+    }
+
+private:
+    bool connected(short a, short b) const {
+        return std::abs(int(a) - int(b)) <= maxDiff;
+    }
+
+    int32_t find(int32_t index) {
+        int32_t root = index;
+        while (parent[root] != root) root = parent[root];
+        while (parent[index] != root) {
+            int32_t next = parent[index];
+            parent[index] = root;
+            index = next;
+        }
+        return root;
+    }
+
+    // Sin compresión: franjas distintas pueden consultar el mismo camino a la vez
+    int32_t findRoot(int32_t index) const {
+        while (parent[index] != index) index = parent[index];
+        return index;
+    }
+
+    void unite(int32_t a, int32_t b) {
+        a = find(a);
+        b = find(b);
+        if (a == b) return;
+        if (componentSize[a] < componentSize[b]) std::swap(a, b);
+        parent[b] = a;
+        componentSize[a] += componentSize[b];
+    }
+
+    cv::Mat map;
+    short invalidValue = -16;
+    int maxSize = 0;
+    int maxDiff = 0;
+    std::vector<int32_t> parent;           // -1 en píxeles inválidos
+    std::vector<int32_t> componentSize;    // Válido en las raíces
+    std::vector<int> removedPerBand;
+};
+
+namespace hole_filling {
+
+/**
+ * Valor de relleno del hueco entre dos extremos válidos
+ */
+inline short fillValue(short first, short last, int step, int length, int maxDifference) {
+    if (std::abs(int(first) - int(last)) > maxDifference) return std::min(first, last);
+    return short(first + (int(last) - int(first)) * step / (length + 1));
+}
+
+/**
+ * Huecos horizontales de las filas [rowBegin, rowEnd)
+ */
+inline void fillRows(cv::Mat& disparity, short invalid, int maxWidth, int maxDifference, int rowBegin, int rowEnd) {
+    for (int y = rowBegin; y < rowEnd; y++) {
+        short* row = disparity.ptr<short>(y);
+        int lastValid = -1;
+        for (int x = 0; x < disparity.cols; x++) {
+            if (row[x] <= invalid) continue;
+            int length = x - lastValid - 1;
+            if (lastValid >= 0 && length > 0 && length <= maxWidth) {
+                for (int k = 1; k <= length; k++) {
+                    row[lastValid + k] = fillValue(row[lastValid], row[x], k, length, maxDifference);
+                }
+            }
+            lastValid = x;
+        }
+    }
+}
+
+/**
+ * Huecos verticales de las columnas [columnBegin, columnEnd), recorriendo por filas
+ * (acceso contiguo) con el último válido de cada columna
+ */
+inline void fillColumns(cv::Mat& disparity, short invalid, int maxWidth, int maxDifference,
+                        int columnBegin, int columnEnd) {
+    std::vector<int> lastValid(columnEnd - columnBegin, -1);
+    for (int y = 0; y < disparity.rows; y++) {
+        const short* row = disparity.ptr<short>(y);
+        for (int x = columnBegin; x < columnEnd; x++) {
+            if (row[x] <= invalid) continue;
+            int& last = lastValid[x - columnBegin];
+            int length = y - last - 1;
+            if (last >= 0 && length > 0 && length <= maxWidth) {
+                short first = disparity.at<short>(last, x);
+                for (int k = 1; k <= length; k++) {
+                    disparity.at<short>(last + k, x) = fillValue(first, row[x], k, length, maxDifference);
+                }
+            }
+            last = y;
+        }
+    }
+}
+
+} // namespace hole_filling
@@ -0,0 +1,255 @@
+/**
+ * GuidedStereoMatcher - Emparejamiento estéreo de descriptores guiado por la disparidad densa
+ * Cada keypoint izquierdo (en coordenadas rectificadas) se lleva a la derecha con la disparidad
+ * SGBM de su píxel y solo se compara con los keypoints derechos a menos de kSearchRadius de la
+ * predicción, indexados en una rejilla de celdas. Test de ratio entre candidatos y validación
+ * cruzada mutua como BFMatcher con crossCheck, con la misma restricción geométrica: desde cada
+ * keypoint derecho elegido se buscan los izquierdos cuya predicción cae a menos de
+ * kSearchRadius (segunda rejilla) y el emparejamiento se acepta solo si su mejor es el mismo
+ */
+
+#pragma once
+
+#include <opencv2/core.hpp>
+#include <opencv2/features2d.hpp>
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <vector>
+
+class GuidedStereoMatcher {
+public:
+    static constexpr float kSearchRadius = 6.0f;   // px a resolución completa
+    static constexpr float kRatio = 0.8f;          // Mejor < 0.8 x segundo candidato
+
+    struct Statistics {
+        int predicted = 0;      // Keypoints izquierdos con disparidad válida
+        int comparisons = 0;    // Distancias de descriptor calculadas
+    };
+
+    /**
+     * Disparidad SGBM (CV_16S, x16) a escala 1/2^level; invalid es la marca de SGBM
+     */
+    void setDisparity(const cv::Mat& disparity, int level, short invalid) {
+        disparityMap = disparity;
+        disparityScale = float(1 << level) / 16.0f;
+        levelShift = level;
+        invalidDisparity = invalid;
+    }
+
+    /**
+     * Emparejamientos left -> right (queryIdx izquierdo, trainIdx derecho). Descriptores
+     * CV_32F (SIFT); devuelve false si el tipo no lo admite y hay que usar fuerza bruta
+     */
+    bool match(const std::vector<cv::Point2f>& left, const std::vector<cv::Point2f>& right,
+               const cv::Mat& leftDescriptors, const cv::Mat& rightDescriptors,
+               std::vector<cv::DMatch>& matches, Statistics& statistics) {
+        matches.clear();
+        statistics = Statistics();
+        if (disparityMap.empty() || leftDescriptors.type() != CV_32F ||
+            rightDescriptors.type() != CV_32F || leftDescriptors.cols != rightDescriptors.cols) {
+            return false;
+        }
+        if (left.empty() || right.empty()) return true;
+
+        // Predicción de cada izquierdo en la imagen derecha (los sin disparidad quedan fuera)
+        predictedLeft.assign(left.size(), cv::Point2f());
+        predictionValid.assign(left.size(), 0);
+        for (size_t leftIdx = 0; leftIdx < left.size(); leftIdx++) {
+            float disparity;
+            if (!lookupDisparity(left[leftIdx], disparity)) continue;
+            predictedLeft[leftIdx] = cv::Point2f(left[leftIdx].x - disparity, left[leftIdx].y);
+            predictionValid[leftIdx] = 1;
+            statistics.predicted++;
+        }
+
+        rightGrid.build(right, nullptr);
+        forward.assign(left.size(), cv::DMatch(-1, -1, FLT_MAX));
+
+        // Ida: mejor derecho de cada izquierdo con test de ratio
+        for (int leftIdx = 0; leftIdx < int(left.size()); leftIdx++) {
+            if (!predictionValid[leftIdx]) continue;
+
+            const float* query = leftDescriptors.ptr<float>(leftIdx);
+            float best = FLT_MAX, second = FLT_MAX;
+            int bestIdx = -1;
+            rightGrid.forEachNear(right, predictedLeft[leftIdx], [&](int rightIdx) {
+                float distance = squaredDistance(query, rightDescriptors.ptr<float>(rightIdx),
+                                                 leftDescriptors.cols, second);
+                statistics.comparisons++;
+                if (distance < best) {
+                    second = best;
+                    best = distance;
+                    bestIdx = rightIdx;
+                } else if (distance < second) {
+                    second = distance;
+                }
+            });
+
+            // Ratio sobre distancias al cuadrado; un único candidato lo acepta la geometría
+            if (bestIdx < 0 || (second < FLT_MAX && best >= kRatio * kRatio * second)) continue;
+            forward[leftIdx] = cv::DMatch(leftIdx, bestIdx, std::sqrt(best));
+        }
+
+        // Vuelta: desde cada derecho elegido, su mejor entre los izquierdos predichos cerca
+        leftGrid.build(predictedLeft, &predictionValid);
+        reverseBest.assign(right.size(), -2); // -2 = sin calcular
+        for (const cv::DMatch& candidate : forward) {
+            if (candidate.queryIdx < 0) continue;
+            int rightIdx = candidate.trainIdx;
+            if (reverseBest[rightIdx] == -2) {
+                const float* query = rightDescriptors.ptr<float>(rightIdx);
+                float best = FLT_MAX;
+                int bestIdx = -1;
+                leftGrid.forEachNear(predictedLeft, right[rightIdx], [&](int leftIdx) {
+                    float distance = squaredDistance(query, leftDescriptors.ptr<float>(leftIdx),
+                                                     rightDescriptors.cols, best);
+                    statistics.comparisons++;
+                    if (distance < best) {
+                        best = distance;
+                        bestIdx = leftIdx;
+                    }
+                });
+                reverseBest[rightIdx] = bestIdx;
+            }
+            if (reverseBest[rightIdx] == candidate.queryIdx) matches.push_back(candidate);
+        }
+        return true;
+    }
+
+private:
+    /**
+     * Rejilla de celdas de lado kSearchRadius sobre un conjunto de puntos (orden por celda)
+     */
+    class PointGrid {
+    public:
+        void build(const std::vector<cv::Point2f>& points, const std::vector<char>* valid) {
+            float minX = FLT_MAX, minY = FLT_MAX, maxX = -FLT_MAX, maxY = -FLT_MAX;
+            for (size_t i = 0; i < points.size(); i++) {
+                if (valid != nullptr && !(*valid)[i]) continue;
+                minX = std::min(minX, points[i].x);
+                minY = std::min(minY, points[i].y);
+                maxX = std::max(maxX, points[i].x);
+                maxY = std::max(maxY, points[i].y);
+            }
+            if (minX > maxX) minX = minY = maxX = maxY = 0.0f; // Sin puntos válidos
+            originX = minX;
+            originY = minY;
+            gridCols = int((maxX - minX) / kSearchRadius) + 1;
+            gridRows = int((maxY - minY) / kSearchRadius) + 1;
+
+            cells.assign(points.size(), -1);
+            cellStart.assign(size_t(gridCols) * gridRows + 1, 0);
+            for (size_t i = 0; i < points.size(); i++) {
+                if (valid != nullptr && !(*valid)[i]) continue;
+                cells[i] = cellCoordinate(points[i].y - originY, gridRows) * gridCols +
+                           cellCoordinate(points[i].x - originX, gridCols);
+                cellStart[cells[i] + 1]++;
+            }
+            for (size_t cell = 1; cell < cellStart.size(); cell++) {
+                cellStart[cell] += cellStart[cell - 1];
+            }
+
+            cellPoints.resize(cellStart.back());
+            std::vector<int> cursor(cellStart.begin(), cellStart.end() - 1);
+            for (size_t i = 0; i < points.size(); i++) {
+                if (cells[i] >= 0) cellPoints[cursor[cells[i]]++] = int(i);
+            }
+        }
+
+        /**
+         * body(índice) para cada punto indexado a menos de kSearchRadius de center
+         */
+        template <typename Body>
+        void forEachNear(const std::vector<cv::Point2f>& points, const cv::Point2f& center, Body&& body) const {
+            const float radiusSquared = kSearchRadius * kSearchRadius;
+            int cellX0 = cellCoordinate(center.x - kSearchRadius - originX, gridCols);
+            int cellX1 = cellCoordinate(center.x + kSearchRadius - originX, gridCols);
+            int cellY0 = cellCoordinate(center.y - kSearchRadius - originY, gridRows);
+            int cellY1 = cellCoordinate(center.y + kSearchRadius - originY, gridRows);
+            for (int cy = cellY0; cy <= cellY1; cy++) {
+                for (int cx = cellX0; cx <= cellX1; cx++) {
+                    int cell = cy * gridCols + cx;
+                    for (int k = cellStart[cell]; k < cellStart[cell + 1]; k++) {
+                        int index = cellPoints[k];
+                        cv::Point2f offset = points[index] - center;
+                        if (offset.dot(offset) <= radiusSquared) body(index);
+                    }
+                }
+            }
+        }
+
+    private:
+        static int cellCoordinate(float offset, int count) {
+            return std::min(std::max(int(std::floor(offset / kSearchRadius)), 0), count - 1);
+        }
+
+        float originX = 0.0f, originY = 0.0f;
+        int gridCols = 0, gridRows = 0;
+        std::vector<int> cells;         // Celda de cada punto (-1 = no indexado)
+        std::vector<int> cellStart;     // Inicio de cada celda en cellPoints (tamaño celdas + 1)
+        std::vector<int> cellPoints;    // Índices ordenados por celda
+    };
+
+    /**
+     * Disparidad a resolución completa en el píxel del keypoint: mediana de los válidos del
+     * entorno 3x3 (las esquinas SIFT suelen caer en bordes donde SGBM deja huecos)
+     */
+    bool lookupDisparity(const cv::Point2f& point, float& disparity) const {
+        if (point.x < 0 || point.y < 0) return false;
+        int x = int(point.x) >> levelShift;
+        int y = int(point.y) >> levelShift;
+        if (x >= disparityMap.cols || y >= disparityMap.rows) return false;
+
+        short values[9];
+        int count = 0;
+        for (int dy = -1; dy <= 1; dy++) {
+            int row = y + dy;
+            if (row < 0 || row >= disparityMap.rows) continue;
+            const short* source = disparityMap.ptr<short>(row);
+            for (int dx = -1; dx <= 1; dx++) {
+                int column = x + dx;
+                if (column < 0 || column >= disparityMap.cols || source[column] <= invalidDisparity) continue;
+                values[count++] = source[column];
+            }
+        }
+        if (count == 0) return false;
+
+        std::nth_element(values, values + count / 2, values + count);
+        disparity = values[count / 2] * disparityScale;
+        return true;
+    }
+
+    /**
+     * Distancia L2 al cuadrado; corta en cuanto supera bound (no puede ser mejor ni segunda)
+     */
+    static float squaredDistance(const float* a, const float* b, int length, float bound) {
+        float sum = 0.0f;
+        int i = 0;
+        for (; i + 8 <= length; i += 8) {
+            for (int k = 0; k < 8; k++) {
+                float difference = a[i + k] - b[i + k];
+                sum += difference * difference;
+            }
+            if (sum > bound) return sum;
+        }
+        for (; i < length; i++) {
+            float difference = a[i] - b[i];
+            sum += difference * difference;
+        }
+        return sum;
+    }
+
+    cv::Mat disparityMap;
+    float disparityScale = 1.0f / 16.0f;
+    int levelShift = 0;
+    short invalidDisparity = -16;
+
+    PointGrid rightGrid;                    // Keypoints derechos
+    PointGrid leftGrid;                     // Predicciones de los izquierdos en la imagen derecha
+    std::vector<cv::Point2f> predictedLeft;
+    std::vector<char> predictionValid;
+    std::vector<cv::DMatch> forward;        // Mejor derecho por izquierdo (queryIdx -1 = ninguno)
+    std::vector<int> reverseBest;           // Mejor izquierdo por derecho elegido
+};
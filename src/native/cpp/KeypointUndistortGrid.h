@@ -0,0 +1,92 @@
+/**
+ * KeypointUndistortGrid - Corrección de lente y rectificación de puntos sueltos
+ * Una malla densa (un nodo cada kStep píxeles) guarda la posición rectificada de cada nodo;
+ * un keypoint se corrige con interpolación bilineal de sus 4 nodos, sin remapear la imagen
+ */
+
+#pragma once
+
+#include <opencv2/calib3d.hpp>
+#include <opencv2/core.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+class KeypointUndistortGrid {
+public:
+    // La distorsión varía suavemente: 16 px deja el error bilineal muy por debajo de 0.05 px
+    static constexpr int kStep = 16;
+
+    bool empty() const {
+        return mapX.empty();
+    }
+
+    /**
+     * Malla a partir de intrínsecos, distorsión y R/P de rectificación (R vacía = solo lente).
+     * Una sola llamada a undistortPoints para todos los nodos, en tiempo de calibración
+     */
+    void build(const cv::Mat& cameraMatrix, const cv::Mat& distortion, const cv::Mat& R, const cv::Mat& P,
+               cv::Size imageSize) {
+        cols = (imageSize.width + kStep - 1) / kStep + 1;
+        rows = (imageSize.height + kStep - 1) / kStep + 1;
+
+        std::vector<cv::Point2f> nodes;
+        nodes.reserve(size_t(cols) * rows);
+        for (int gy = 0; gy < rows; gy++) {
+            for (int gx = 0; gx < cols; gx++) {
+                nodes.emplace_back(float(gx * kStep), float(gy * kStep));
+            }
+        }
+
+        std::vector<cv::Point2f> corrected;
+        cv::undistortPoints(nodes, corrected, cameraMatrix, distortion, R, P);
+
+        // Estructura de arrays: cada eje contiguo para la interpolación
+        mapX.resize(corrected.size());
+        mapY.resize(corrected.size());
+        for (size_t i = 0; i < corrected.size(); i++) {
+            mapX[i] = corrected[i].x;
+            mapY[i] = corrected[i].y;
+        }
+    }
+
+    /**
+     * Píxeles en bruto -> coordenadas rectificadas. Bucle sin ramas ni dependencias entre
+     * keypoints (fuera de la imagen se extrapola la celda del borde), apto para vectorizar
+     */
+    void apply(const std::vector<cv::Point2f>& raw, std::vector<cv::Point2f>& corrected) const {
+        corrected.resize(raw.size());
+        if (mapX.empty()) {
+            std::copy(raw.begin(), raw.end(), corrected.begin());
+            return;
+        }
+
+        const float inverseStep = 1.0f / kStep;
+        const float maxCellX = float(cols - 2), maxCellY = float(rows - 2);
+        const float* nodesX = mapX.data();
+        const float* nodesY = mapY.data();
+        const size_t count = raw.size();
+
+        for (size_t i = 0; i < count; i++) {
+            float gx = raw[i].x * inverseStep;
+            float gy = raw[i].y * inverseStep;
+            float cellX = std::min(std::max(std::floor(gx), 0.0f), maxCellX);
+            float cellY = std::min(std::max(std::floor(gy), 0.0f), maxCellY);
+            float ax = gx - cellX, ay = gy - cellY;
+
+            int index = int(cellY) * cols + int(cellX);
+            float w00 = (1.0f - ax) * (1.0f - ay), w01 = ax * (1.0f - ay);
+            float w10 = (1.0f - ax) * ay, w11 = ax * ay;
+
+            corrected[i].x = w00 * nodesX[index] + w01 * nodesX[index + 1] +
+                             w10 * nodesX[index + cols] + w11 * nodesX[index + cols + 1];
+            corrected[i].y = w00 * nodesY[index] + w01 * nodesY[index + 1] +
+                             w10 * nodesY[index + cols] + w11 * nodesY[index + cols + 1];
+        }
+    }
+
+private:
+    int cols = 0, rows = 0;
+    std::vector<float> mapX, mapY;
+};
@@ -8,19 +8,45 @@
  */
 
 #include "NativeCameraProcessor.h"
+#include "CalibrationCache.h"
+#include "CaptureRecorder.h"
+#include "CompactDescriptors.h"
+#include "DepthIntegralImages.h"
+#include "DepthMesher.h"
+#include "DepthStreamCodec.h"
+#include "DisparityCleanup.h"
+#include "GuidedStereoMatcher.h"
+#include "PipelineTask.h"
+#include "PlaneDetector.h"
+#include "PlyStreamWriter.h"
+#include "RectifiedTileCache.h"
+#include "SensorFusionEngine.h"
+#include "SparseDisparity.h"
+#include "StageGraph.h"
+#include "StereoPreprocess.h"
+#include "SubpixelRefiner.h"
+#include "ThreadPool.h"
 #include <opencv2/opencv.hpp>
 #include <opencv2/calib3d.hpp>
 #include <opencv2/imgproc.hpp>
 #include <opencv2/features2d.hpp>
+#include <opencv2/video.hpp>
 #include <opencv2/xfeatures2d.hpp>
 #include <chrono>
 #include <thread>
 #include <mutex>
 #include <condition_variable>
 #include <algorithm>
+#include <array>
+#include <atomic>
+#include <cfloat>
+#include <climits>
 #include <cmath>
+#include <functional>
+#include <memory>
+#include <shared_mutex>
+#include <unordered_map>
 #include <vector>
-#include <map>
 
 using namespace cv;
 using namespace std;
@@ -31,40 +57,222 @@ private:
     int cameraCount;
     Size imageSize;
     
-    // Matrices de calibración para cada cámara
-    vector<Mat> cameraMatrices;
-    vector<Mat> distortionCoefficients;
-    vector<Mat> rotationMatrices;
-    vector<Mat> translationVectors;
+    // Calibración (intrínsecos, extrínsecos, mapas y Q), compartible entre instancias
+    shared_ptr<CalibrationCache> calibration;
     
-    // Mapas de rectificación estereoscópica
-    vector<Mat> rectifyMaps1, rectifyMaps2;
-    Mat Q; // Matriz de disparidad a 3D
+    // Pool de hilos para trabajo por cámara, compartible entre instancias
+    shared_ptr<ThreadPool> threadPool;
+    
+    // Fusión IMU de proceso: pose del rig en el instante de captura de cada frame
+    shared_ptr<SensorFusionEngine> fusionEngine;
     
     // Sincronización temporal
     mutex frameMutex;
     condition_variable frameCondition;
-    map<int, Mat> currentFrames;
-    map<int, double> frameTimestamps;
     
-    // Buffers para procesamiento
-    vector<Mat> processedFrames;
+    // Ranura fija por cámara: se reutiliza frame a frame, indexada por cameraId en O(1)
+    struct CameraFrameSlot {
+        Mat frame;
+        double timestamp = 0.0;
+        bool valid = false;
+        RigPose pose;           // Pose IMU interpolada al timestamp del frame
+        bool poseValid = false;
+        double sharpness = 0.0; // Varianza del Laplaciano en luma reducida
+    };
+    vector<CameraFrameSlot> frameSlots;
+    int validFrameCount;
+    
+    // Ranuras de ingesta: el conjunto entrante se evalúa aquí y solo se intercambia
+    // con frameSlots si supera el filtro de nitidez
+    vector<CameraFrameSlot> ingestSlots;
+    
+    // Umbrales de nitidez y de velocidad angular para descartar frames movidos
+    struct SharpnessGate {
+        double minSharpness = 60.0;
+        double maxAngularRate = 2.0; // rad/s
+    };
+    SharpnessGate sharpnessGate;
+    uint64_t rejectedFrameSets;
+    
+    // Roles explícitos del par estereoscópico (índices de cámara)
+    int stereoLeftCamera;
+    int stereoRightCamera;
+    
+    // Modo de procesamiento y etapas activas (cierre del grafo de etapas)
+    ProcessingMode processingMode;
+    StageMask activeStages;
+    int processingLevel; // Nivel de la pirámide de rectificación (escala 1/2^nivel)
+    
+    // Salidas pedidas y grafo efectivo: el modo de emparejamiento puede añadir entradas
+    StageMask requestedOutputs;
+    FeatureMatchMode featureMatchMode;
+    StageInputs stageInputs;
+    array<int, kStageCount> stageLevels;
+    
+    // Versionado de salidas: una etapa solo se recalcula si cambió la versión de sus entradas
+    uint64_t frameId;
+    array<StageVersion, kStageCount> stageVersions;
+    array<uint64_t, kStageCount> stageParameterVersions;
+    
+    // Gris rectificado por cámara (perezoso por teselas), igualado en exposición a la izquierda
+    vector<unique_ptr<RectifiedTileCache>> rectifiedTiles;
+    vector<PhotometricGain> photometricGains;
+    bool stereoClaheEnabled;
+    
+    // Región de interés estéreo (vacía = frame completo): SGBM solo en su franja de filas
+    Rect stereoRegion;
     Mat disparityMap;
+    int disparityMinimum; // minDisparity del último SGBM (inválido = (mín - 1) * 16)
+    int disparityRange;   // numDisparities del último SGBM
+    
+    // Limpieza paralela de la disparidad: motas (parámetros del filtro previo de SGBM, área
+    // a resolución completa) y huecos de hasta kMaxHoleWidth píxeles
+    static constexpr int kSpeckleWindowSize = 200;
+    static constexpr int kSpeckleRange = 25;
+    static constexpr int kMaxHoleWidth = 12;
+    static constexpr int kHoleSurfaceDifference = 16; // 1 px de disparidad: misma superficie
+    SpeckleFilter speckleFilter;
     Mat depthMap;
+    Mat depthStreamZ; // Canal Z reutilizado por el codificador del flujo de profundidad
+    
+    // Integrales de la profundidad (normales; estadísticas de región si ya están al día) y
+    // mapa de normales. depthIntegralsReady es la versión de las integrales terminadas
+    static constexpr int kNormalWindowRadius = 6;
+    DepthIntegralImages depthIntegrals;
+    atomic<StageVersion> depthIntegralsReady{kStageNeverComputed};
+    Mat normalMap;
     
     // Detección de características
     Ptr<SIFT> siftDetector;
     Ptr<BFMatcher> matcher;
+    GuidedStereoMatcher guidedMatcher;
+    compact_descriptors::CompactDescriptorMatcher compactMatcher; // Base PCA fija tras entrenarse
+    bool compactDescriptorsEnabled;
+    
+    // Refinamiento subpíxel por lotes: esquinas de calibración (ventana 23x23, la de
+    // cornerSubPix con winSize (11, 11), que es media ventana) y puntos de triangulación y
+    // medición (ventana 9x9)
+    subpixel::SubpixelRefiner cornerRefiner;
+    subpixel::SubpixelRefiner pointRefiner;
+    vector<Mat> featureGrays;       // Gris de la detección SIFT (refinamiento de correspondencias)
+    
+    // Salidas de las etapas de características y triangulación
+    vector<vector<KeyPoint>> frameKeypoints;
+    vector<Mat> frameDescriptors;
+    vector<Point2f> matchedPointsLeft, matchedPointsRight;
+    vector<Point2f> refinedPointsLeft, refinedPointsRight; // Entradas subpíxel de la triangulación
+    vector<Point3f> triangulatedPoints;
+    vector<float> triangulationErrors; // Error de reproyección medio por punto (px)
+    
+    // Seguimiento temporal de la cámara izquierda
+    static constexpr int kMinTrackedFeatures = 150;
+    static constexpr int kMaxTrackedFeatures = 400;
+    vector<Point2f> trackedPoints;
+    
+    // Rango completo de SGBM, límite de un rango estimado (objetos cercanos) y teselas para
+    // predecir el rango del frame siguiente
+    static constexpr int kMaxDisparities = 128;
+    static constexpr int kDisparitySearchLimit = 256;
+    static constexpr int kDisparityTileGrid = 8;
+    static constexpr int kDisparityMargin = 8;
+    
+    // Un rango predicho solo crece kDisparityMargin por frame: si el mapa toca sus extremos
+    // (más de un kDisparityEdgePercent % de los válidos) o tras kDisparityPriorFrames frames
+    // seguidos con predicción, se vuelve a estimar con las correspondencias dispersas
+    static constexpr int kDisparityEdgePercent = 1;
+    static constexpr int kDisparityPriorFrames = 30;
     
-    // Parámetros de calibración automática
+    // Referencia del frame anterior para predecir el movimiento con el giroscopio
+    struct TemporalReference {
+        Mat data;               // Gris (KLT) o rangos de disparidad por tesela (SGBM)
+        RigPose pose;
+        bool poseValid = false;
+        uint64_t calibrationVersion = 0;
+    };
+    TemporalReference trackingReference;
+    TemporalReference disparityReference;
+    bool disparityRangeClipped = false;     // El mapa de la referencia toca los extremos del rango
+    int disparityPriorFrames = 0;           // Frames seguidos con rango predicho
+    
+    // Esquinas del patrón detectadas por cámara en el frame actual
+    vector<vector<Point2f>> calibrationCorners;
+    vector<char> calibrationCornersFound;
+    vector<Mat> calibrationGrays;
+    
+    // Región de medición y estadísticas de profundidad resultantes
+    Rect measurementRoi;
+    
+public:
+    struct DepthStatistics {
+        double meanDepth = 0.0;
+        double stdDepth = 0.0;
+        double uncertainty95 = 0.0;
+        int validPixels = 0;
+    };
+    
+private:
+    DepthStatistics depthStatistics;
+    
+    // Plano dominante restringido por la gravedad de la IMU
+    PlaneOrientation planeOrientation;
+    PlaneSearchParams planeSearchParams;
+    PlaneFit dominantPlane;
+    
+    // Rotación ejes del dispositivo (IMU) -> ejes de la cámara
+    Matx33d imuToCamera;
+    
+    // Malla de la profundidad para la UI, decimada a un presupuesto de triángulos
+    DepthMesher depthMesher;
+    SurfaceMesh surfaceMesh;
+    int meshTriangleBudget;
+    
+    // Plano de referencia conocido (marco de la cámara, mm) para medir con una sola cámara
+    PlaneFit referencePlane;
+    
+    // Parámetros de calibración automática: esquinas por cámara y por vista
     vector<vector<Point3f>> objectPoints3D;
-    vector<vector<Point2f>> imagePointsPerCamera;
+    vector<vector<vector<Point2f>>> imagePointsPerCamera;
+    static constexpr size_t kMinCalibrationViews = 10;
+    
+    // Grabación de los conjuntos de entrada para reprocesado offline (nula = sin grabar)
+    unique_ptr<CaptureRecorder> recorder;
     
 public:
-    NativeCameraProcessor() : 
+    explicit NativeCameraProcessor(shared_ptr<ThreadPool> sharedPool = nullptr,
+                                   shared_ptr<CalibrationCache> sharedCalibration = nullptr) : 
         cameraCount(0),
+        calibration(sharedCalibration ? sharedCalibration : make_shared<CalibrationCache>()),
+        threadPool(sharedPool ? sharedPool : make_shared<ThreadPool>()),
+        fusionEngine(SensorFusionEngine::instance()),
+        validFrameCount(0),
+        rejectedFrameSets(0),
+        stereoLeftCamera(0),
+        stereoRightCamera(1),
+        processingMode(ProcessingMode::FullReconstruction),
+        activeStages(resolveStageClosure(requestedOutputsForMode(ProcessingMode::FullReconstruction),
+                                         defaultStageInputs())),
+        processingLevel(processingLevelForMode(ProcessingMode::FullReconstruction)),
+        requestedOutputs(requestedOutputsForMode(ProcessingMode::FullReconstruction)),
+        featureMatchMode(FeatureMatchMode::BruteForce),
+        stageInputs(stageInputsForMatchMode(FeatureMatchMode::BruteForce)),
+        stageLevels(computeStageLevels(stageInputs)),
+        frameId(0),
+        stereoClaheEnabled(false),
+        disparityMinimum(0),
+        disparityRange(0),
         siftDetector(SIFT::create(0, 3, 0.04, 10, 1.6)),
-        matcher(BFMatcher::create(NORM_L2, true)) {
+        matcher(BFMatcher::create(NORM_L2, true)),
+        compactDescriptorsEnabled(false),
+        cornerRefiner(11, 30, 0.01f),
+        pointRefiner(4, 20, 0.01f),
+        planeOrientation(PlaneOrientation::Horizontal),
+        // Cámara trasera con sensor a 90°: x_cam = -y_disp, y_cam = -x_disp, z_cam = -z_disp
+        imuToCamera(0, -1, 0,
+                    -1, 0, 0,
+                    0, 0, -1),
+        meshTriangleBudget(20000) {
+        stageVersions.fill(kStageNeverComputed);
+        stageParameterVersions.fill(0);
     }
     
     /**
@@ -74,15 +282,35 @@ public:
         cameraCount = numCameras;
         imageSize = Size(width, height);
         
-        // Inicializar estructuras para cada cámara
-        cameraMatrices.resize(cameraCount);
-        distortionCoefficients.resize(cameraCount);
-        rotationMatrices.resize(cameraCount);
-        translationVectors.resize(cameraCount);
-        rectifyMaps1.resize(cameraCount);
-        rectifyMaps2.resize(cameraCount);
-        processedFrames.resize(cameraCount);
+        // Inicializar estructuras para cada cámara (la caché puede venir de otra instancia)
+        if (!calibration->ensureCameraCount(cameraCount, imageSize)) {
+            cerr << "❌ La calibración compartida es de " << calibration->imageSize.width << "x"
+                 << calibration->imageSize.height << ", no de " << width << "x" << height
+                 << ": comparte la resolución de captura y usa el nivel de procesamiento" << endl;
+            return false;
+        }
+        rectifiedTiles.clear();
+        for (int camIdx = 0; camIdx < cameraCount; camIdx++) {
+            rectifiedTiles.push_back(make_unique<RectifiedTileCache>());
+        }
+        photometricGains.assign(cameraCount, PhotometricGain());
         imagePointsPerCamera.resize(cameraCount);
+        frameSlots.assign(cameraCount, CameraFrameSlot());
+        ingestSlots.assign(cameraCount, CameraFrameSlot());
+        validFrameCount = 0;
+        frameKeypoints.assign(cameraCount, vector<KeyPoint>());
+        frameDescriptors.assign(cameraCount, Mat());
+        calibrationCorners.assign(cameraCount, vector<Point2f>());
+        calibrationCornersFound.assign(cameraCount, 0);
+        calibrationGrays.assign(cameraCount, Mat());
+        featureGrays.assign(cameraCount, Mat());
+        measurementRoi = Rect();
+        stageVersions.fill(kStageNeverComputed);
+        depthIntegralsReady.store(kStageNeverComputed);
+        
+        // Par estéreo por defecto: cámaras 0 y 1 (reasignable con setStereoPair)
+        stereoLeftCamera = 0;
+        stereoRightCamera = cameraCount >= 2 ? 1 : 0;
         
         // Inicializar detector de características SIFT para máxima precisión
         siftDetector = SIFT::create(
@@ -97,17 +325,397 @@ public:
         cout << "   - Cámaras: " << cameraCount << endl;
         cout << "   - Resolución: " << width << "x" << height << endl;
         cout << "   - Detector: SIFT con parámetros profesionales" << endl;
+        cout << "   - Hilos de trabajo: " << threadPool->size() << endl;
+        
+        return true;
+    }
+    
+    /**
+     * Selección de modo: solo se ejecutan las etapas necesarias para sus salidas
+     */
+    void setProcessingMode(ProcessingMode mode) {
+        lock_guard<mutex> lock(frameMutex);
+        processingMode = mode;
+        requestedOutputs = requestedOutputsForMode(mode);
+        activeStages = resolveStageClosure(requestedOutputs, stageInputs);
+        
+        int level = processingLevelForMode(mode);
+        if (level != processingLevel) {
+            // Las disparidades del frame anterior están en la escala del nivel previo
+            processingLevel = level;
+            disparityReference = TemporalReference();
+        }
+        
+        cout << "⚙️ Modo de procesamiento: " << processingModeName(mode)
+             << " (escala 1/" << (1 << processingLevel) << ")" << endl;
+    }
+    
+    /**
+     * Salidas explícitas (máscara de etapas) para combinaciones fuera de los modos predefinidos
+     */
+    void setRequestedOutputs(StageMask outputs) {
+        lock_guard<mutex> lock(frameMutex);
+        requestedOutputs = outputs;
+        activeStages = resolveStageClosure(outputs, stageInputs);
+    }
+    
+    /**
+     * Emparejamiento estéreo de descriptores: fuerza bruta o guiado por la disparidad densa
+     * (el guiado añade SGBM al cierre de las salidas pedidas)
+     */
+    void setFeatureMatchMode(FeatureMatchMode mode) {
+        lock_guard<mutex> lock(frameMutex);
+        if (mode == featureMatchMode) return;
+        
+        featureMatchMode = mode;
+        stageInputs = stageInputsForMatchMode(mode);
+        stageLevels = computeStageLevels(stageInputs);
+        activeStages = resolveStageClosure(requestedOutputs, stageInputs);
+        stageParameterVersions[static_cast<int>(PipelineStage::FeatureMatch)]++;
+    }
+    
+    shared_ptr<ThreadPool> getThreadPool() const {
+        return threadPool;
+    }
+    
+    shared_ptr<CalibrationCache> getCalibrationCache() const {
+        return calibration;
+    }
+    
+    /**
+     * Asignación explícita de roles izquierda/derecha del par estereoscópico
+     */
+    bool setStereoPair(int leftCamera, int rightCamera) {
+        if (leftCamera == rightCamera ||
+            leftCamera < 0 || leftCamera >= cameraCount ||
+            rightCamera < 0 || rightCamera >= cameraCount) {
+            cerr << "❌ Par estéreo inválido: " << leftCamera << "/" << rightCamera << endl;
+            return false;
+        }
+        
+        lock_guard<mutex> lock(frameMutex);
+        stereoLeftCamera = leftCamera;
+        stereoRightCamera = rightCamera;
+        return true;
+    }
+    
+    /**
+     * Umbrales del filtro de desenfoque (nitidez mínima 0 y velocidad angular 0 lo desactivan)
+     */
+    void setSharpnessGate(double minSharpness, double maxAngularRate) {
+        lock_guard<mutex> lock(frameMutex);
+        sharpnessGate.minSharpness = minSharpness;
+        sharpnessGate.maxAngularRate = maxAngularRate;
+    }
+    
+    /**
+     * CLAHE opcional tras la normalización (escenas con mucho contraste local)
+     */
+    void setStereoClahe(bool enabled) {
+        lock_guard<mutex> lock(frameMutex);
+        if (enabled == stereoClaheEnabled) return;
+        
+        stereoClaheEnabled = enabled;
+        stageParameterVersions[static_cast<int>(PipelineStage::Rectify)]++;
+    }
+    
+    /**
+     * Región estéreo: la disparidad (y la rectificación que consume) se limita a sus filas
+     * a ancho completo; fuera de ella el mapa de disparidad queda inválido
+     */
+    void setStereoRegion(const Rect& region) {
+        lock_guard<mutex> lock(frameMutex);
+        if (region == stereoRegion) return;
+        
+        stereoRegion = region;
+        stageParameterVersions[static_cast<int>(PipelineStage::StereoMatch)]++;
+    }
+    
+    /**
+     * Fuerza bruta sobre descriptores PCA int8 con revisión float de los mejores candidatos.
+     * La base se entrena con los descriptores del primer par que tenga suficientes
+     */
+    void setCompactDescriptors(bool enabled) {
+        lock_guard<mutex> lock(frameMutex);
+        if (enabled == compactDescriptorsEnabled) return;
+        
+        compactDescriptorsEnabled = enabled;
+        stageParameterVersions[static_cast<int>(PipelineStage::FeatureMatch)]++;
+    }
+    
+    /**
+     * Región de medición para estadísticas de profundidad (vacía = imagen completa).
+     * Solo invalida la etapa de estadísticas: disparidad y profundidad siguen en caché
+     */
+    void setMeasurementRoi(const Rect& roi) {
+        lock_guard<mutex> lock(frameMutex);
+        if (roi == measurementRoi) return;
+        
+        measurementRoi = roi;
+        stageParameterVersions[static_cast<int>(PipelineStage::DepthStatistics)]++;
+    }
+    
+    /**
+     * Recalcula bajo demanda sobre el frame actual solo las salidas obsoletas.
+     * Devuelve el número de etapas ejecutadas (0 = todo servido desde caché)
+     */
+    int refreshOutputs(StageMask outputs) {
+        lock_guard<mutex> lock(frameMutex);
+        shared_lock<shared_mutex> calibrationLock(calibration->mutex);
+        return evaluateStages(resolveStageClosure(outputs, stageInputs));
+    }
+    
+    /**
+     * Consulta de estadísticas de profundidad en una región; repetida sobre el mismo frame
+     * solo recalcula la etapa de estadísticas cuando la región cambia
+     */
+    DepthStatistics queryDepthStatistics(const Rect& roi) {
+        setMeasurementRoi(roi);
+        refreshOutputs(stageBit(PipelineStage::DepthStatistics));
+        
+        lock_guard<mutex> lock(frameMutex);
+        return depthStatistics;
+    }
+    
+    /**
+     * Profundidad del frame actual en el formato compacto de depth_stream (Z cuantizada a stepMm)
+     */
+    bool encodeDepthStream(vector<uint8_t>& encoded, float stepMm) {
+        // Un paso menor que kMinStepMm no representa todo el rango; NaN no pasa la comparación.
+        // Se rechaza antes de recalcular rectificación, SGBM y reproyección
+        if (!isfinite(stepMm) || !(stepMm >= depth_stream::kMinStepMm)) {
+            cerr << "❌ Paso de profundidad no válido: " << stepMm << " mm (mínimo "
+                 << depth_stream::kMinStepMm << " mm)" << endl;
+            return false;
+        }
+        
+        refreshOutputs(stageBit(PipelineStage::Reproject));
+        
+        lock_guard<mutex> lock(frameMutex);
+        if (depthMap.empty()) return false;
+        
+        extractChannel(depthMap, depthStreamZ, 2);
+        depth_stream::encodeDepthFrame(depthStreamZ, stepMm, encoded);
+        
+        cout << "📦 Profundidad codificada: " << encoded.size() << " bytes (" 
+             << depthMap.total() * depthMap.elemSize() << " en bruto)" << endl;
+        return true;
+    }
+    
+    /**
+     * Graba cada conjunto que llegue a processMultiFrame en un anillo de capacityBytes.
+     * La grabación anterior se cierra antes de abrir la nueva: open trunca el archivo, que
+     * puede ser el mismo que la anterior aún tiene mapeado
+     */
+    bool startRecording(const string& path, uint64_t capacityBytes) {
+        stopRecording();
         
+        auto newRecorder = make_unique<CaptureRecorder>();
+        if (!newRecorder->open(path, capacityBytes)) return false;
+        
+        lock_guard<mutex> lock(frameMutex);
+        recorder = std::move(newRecorder);
         return true;
     }
     
+    /**
+     * Detiene la grabación; el vaciado de la cola ocurre fuera del lock de frames
+     */
+    void stopRecording() {
+        unique_ptr<CaptureRecorder> finished;
+        {
+            lock_guard<mutex> lock(frameMutex);
+            finished = std::move(recorder);
+        }
+        if (finished) finished->close();
+    }
+    
+    /**
+     * Reprocesa una grabación conjunto a conjunto por el mismo camino que la entrada en vivo.
+     * Devuelve los conjuntos reproducidos (-1 si no se puede abrir o se está grabando)
+     */
+    int replayRecording(const string& path) {
+        {
+            lock_guard<mutex> lock(frameMutex);
+            if (recorder) {
+                cerr << "❌ No se puede reproducir mientras se graba" << endl;
+                return -1;
+            }
+        }
+        
+        CaptureReader reader;
+        if (!reader.open(path)) return -1;
+        
+        CapturedFrameSet set;
+        int replayed = 0;
+        for (size_t i = 0; i < reader.size(); i++) {
+            if (!reader.read(i, set)) continue;
+            processMultiFrame(set.frames, set.timestamps, set.cameraIds);
+            replayed++;
+        }
+        
+        cout << "▶️ Grabación reproducida: " << replayed << " conjuntos" << endl;
+        return replayed;
+    }
+    
+    enum class PointCloudSource {
+        Triangulated = 0,   // Puntos SIFT triangulados
+        DenseDepth = 1,     // Todos los píxeles con profundidad válida
+        Voxelized = 2       // Profundidad densa reducida a un centroide por vóxel
+    };
+    
+    struct PointCloudExportOptions {
+        PointCloudSource source = PointCloudSource::DenseDepth;
+        bool colors = true;
+        bool confidence = true;
+        float voxelSize = 5.0f; // mm
+    };
+    
+    /**
+     * Exporta la nube del frame actual a PLY binario. Bajo los locks solo se toma una
+     * instantánea de la fuente (Z y color rectificado, o los puntos triangulados); los
+     * puntos se generan y escriben por bloques después, en el hilo del llamador.
+     * Devuelve los puntos escritos (-1 si no hay datos o falla la escritura)
+     */
+    int64_t exportPointCloud(const string& path, const PointCloudExportOptions& options) {
+        bool dense = options.source != PointCloudSource::Triangulated;
+        refreshOutputs(stageBit(dense ? PipelineStage::Reproject : PipelineStage::Triangulate));
+        
+        Mat depthZ, colorImage;
+        Matx44d Q;
+        vector<Point3f> points;
+        vector<Vec3b> pointColors;
+        vector<float> pointConfidences;
+        {
+            lock_guard<mutex> lock(frameMutex);
+            shared_lock<shared_mutex> calibrationLock(calibration->mutex);
+            const CameraFrameSlot& leftSlot = frameSlots[stereoLeftCamera];
+            
+            if (dense) {
+                if (depthMap.empty()) return -1;
+                extractChannel(depthMap, depthZ, 2);
+                Q = Matx44d(calibration->pyramidQ[processingLevel]);
+                
+                const Mat& map1 = calibration->rectifyMaps1[processingLevel][stereoLeftCamera];
+                if (options.colors && leftSlot.valid && map1.size() == depthZ.size()) {
+                    remap(leftSlot.frame, colorImage, map1,
+                          calibration->rectifyMaps2[processingLevel][stereoLeftCamera], INTER_LINEAR);
+                }
+            } else {
+                if (triangulatedPoints.empty()) return -1;
+                points = triangulatedPoints;
+                
+                // Color en la posición del keypoint izquierdo en bruto; confianza por reproyección
+                size_t count = points.size();
+                if (options.colors && leftSlot.valid && matchedPointsLeft.size() == count) {
+                    pointColors.resize(count);
+                    for (size_t i = 0; i < count; i++) {
+                        int x = min(max(cvRound(matchedPointsLeft[i].x), 0), leftSlot.frame.cols - 1);
+                        int y = min(max(cvRound(matchedPointsLeft[i].y), 0), leftSlot.frame.rows - 1);
+                        pointColors[i] = leftSlot.frame.at<Vec3b>(y, x);
+                    }
+                }
+                pointConfidences.assign(count, 1.0f);
+                for (size_t i = 0; i < min(count, triangulationErrors.size()); i++) {
+                    pointConfidences[i] = 1.0f / (1.0f + triangulationErrors[i]);
+                }
+            }
+        }
+        
+        bool withColors = dense ? !colorImage.empty() : !pointColors.empty();
+        PlyStreamWriter writer;
+        if (!writer.open(path, withColors, options.confidence)) {
+            cerr << "❌ No se pudo crear el PLY: " << path << endl;
+            return -1;
+        }
+        
+        if (!dense) {
+            for (size_t i = 0; i < points.size(); i++) {
+                writer.add(points[i], withColors ? pointColors[i] : Vec3b(), pointConfidences[i]);
+            }
+        } else if (options.source == PointCloudSource::DenseDepth) {
+            forEachDepthPoint(depthZ, colorImage, Q, [&](const Point3f& point, const Vec3b& color, float confidence) {
+                writer.add(point, color, confidence);
+            });
+        } else {
+            writeVoxelizedCloud(writer, depthZ, colorImage, Q, options.voxelSize);
+        }
+        
+        uint64_t written = writer.count();
+        if (!writer.finish()) {
+            cerr << "❌ Error escribiendo el PLY: " << path << endl;
+            return -1;
+        }
+        
+        cout << "☁️ Nube exportada: " << written << " puntos en " << path << endl;
+        return int64_t(written);
+    }
+    
+    /**
+     * Rotación de los ejes de la IMU a los de la cámara izquierda (según orientación del sensor)
+     */
+    void setImuToCameraRotation(const Matx33d& rotation) {
+        lock_guard<mutex> lock(frameMutex);
+        imuToCamera = rotation;
+        stageParameterVersions[static_cast<int>(PipelineStage::PlaneDetect)]++;
+    }
+    
+    /**
+     * Plano dominante del frame actual con la orientación pedida; la profundidad se reutiliza
+     * de la caché y solo se repite el RANSAC si cambia la orientación
+     */
+    PlaneFit queryDominantPlane(PlaneOrientation orientation) {
+        {
+            lock_guard<mutex> lock(frameMutex);
+            if (orientation != planeOrientation) {
+                planeOrientation = orientation;
+                stageParameterVersions[static_cast<int>(PipelineStage::PlaneDetect)]++;
+            }
+        }
+        refreshOutputs(stageBit(PipelineStage::PlaneDetect));
+        
+        lock_guard<mutex> lock(frameMutex);
+        return dominantPlane;
+    }
+    
+    /**
+     * Malla del frame actual con el presupuesto de triángulos pedido (<= 0 = sin decimar).
+     * Se sirve de la caché mientras no cambien la profundidad ni el presupuesto
+     */
+    SurfaceMesh queryMesh(int triangleBudget) {
+        {
+            lock_guard<mutex> lock(frameMutex);
+            if (triangleBudget != meshTriangleBudget) {
+                meshTriangleBudget = triangleBudget;
+                stageParameterVersions[static_cast<int>(PipelineStage::SurfaceMesh)]++;
+            }
+        }
+        refreshOutputs(stageBit(PipelineStage::SurfaceMesh));
+        
+        lock_guard<mutex> lock(frameMutex);
+        return surfaceMesh;
+    }
+    
+    /**
+     * Normal unitaria de la superficie en un píxel del mapa de profundidad (orientada hacia la
+     * cámara, marco rectificado izquierdo); false si no hay profundidad fiable alrededor
+     */
+    bool querySurfaceNormal(Point pixel, Vec3f& normal) {
+        refreshOutputs(stageBit(PipelineStage::SurfaceNormals));
+        
+        lock_guard<mutex> lock(frameMutex);
+        if (normalMap.empty() || !Rect(0, 0, normalMap.cols, normalMap.rows).contains(pixel)) return false;
+        normal = normalMap.at<Vec3f>(pixel);
+        return normal[2] != 0.0f;
+    }
+    
     /**
      * Calibración automática usando algoritmos de Zhang y Bundle Adjustment
      * Implementa matemáticas exactas sin aproximaciones
      */
     bool performAutomaticCalibration() {
-        if (cameraCount < 2) {
-            cerr << "❌ Se requieren al menos 2 cámaras para calibración estereoscópica" << endl;
+        if (cameraCount < 1) {
+            cerr << "❌ Procesador sin cámaras inicializadas" << endl;
             return false;
         }
         
@@ -122,52 +730,201 @@ public:
             }
         }
         
+        // Copia de las vistas y del par estéreo: la etapa de esquinas las amplía bajo frameMutex
+        vector<vector<vector<Point2f>>> views;
+        int leftCamera, rightCamera;
+        {
+            lock_guard<mutex> frameLock(frameMutex);
+            views = imagePointsPerCamera;
+            leftCamera = stereoLeftCamera;
+            rightCamera = stereoRightCamera;
+        }
+        
+        // Cámaras imprescindibles: el par estéreo, o la única cámara en modo monocular
+        bool stereo = cameraCount >= 2;
+        if (stereo && (leftCamera == rightCamera || max(leftCamera, rightCamera) >= cameraCount)) {
+            cerr << "❌ Par estéreo no válido (" << leftCamera << "/" << rightCamera << ")" << endl;
+            return false;
+        }
+        vector<int> requiredCameras = stereo ? vector<int>{leftCamera, rightCamera} : vector<int>{0};
+        for (int camIdx : requiredCameras) {
+            if (views[camIdx].size() < kMinCalibrationViews) {
+                cerr << "❌ Insuficientes vistas de calibración para cámara " << camIdx << " ("
+                     << views[camIdx].size() << "/" << kMinCalibrationViews << ")" << endl;
+                return false;
+            }
+        }
+        
         cout << "🎯 Iniciando calibración automática con algoritmo de Zhang..." << endl;
         
         // Calibración individual de cada cámara
+        unique_lock<shared_mutex> calibrationLock(calibration->mutex);
         for (int camIdx = 0; camIdx < cameraCount; camIdx++) {
-            if (imagePointsPerCamera[camIdx].size() < 10) {
-                cerr << "❌ Insuficientes puntos de calibración para cámara " << camIdx << endl;
+            if (views[camIdx].size() < kMinCalibrationViews) {
+                cerr << "❌ Insuficientes vistas de calibración para cámara " << camIdx << endl;
                 continue;
             }
             
-            vector<vector<Point3f>> objectPoints(imagePointsPerCamera[camIdx].size(), patternPoints);
+            vector<vector<Point3f>> objectPoints(views[camIdx].size(), patternPoints);
             
             // Calibración monocular usando método de Zhang
             double rms = calibrateCamera(
                 objectPoints,
-                vector<vector<Point2f>>(1, imagePointsPerCamera[camIdx]),
+                views[camIdx],
                 imageSize,
-                cameraMatrices[camIdx],
-                distortionCoefficients[camIdx],
+                calibration->cameraMatrices[camIdx],
+                calibration->distortionCoefficients[camIdx],
                 vector<Mat>(), // rvecs
                 vector<Mat>(), // tvecs
                 CALIB_FIX_PRINCIPAL_POINT | CALIB_FIX_ASPECT_RATIO | CALIB_ZERO_TANGENT_DIST
             );
             
             cout << "📐 Cámara " << camIdx << " calibrada - RMS: " << rms << endl;
-            cout << "   Matriz intrínseca:" << endl << cameraMatrices[camIdx] << endl;
-            cout << "   Distorsión:" << endl << distortionCoefficients[camIdx] << endl;
+            cout << "   Matriz intrínseca:" << endl << calibration->cameraMatrices[camIdx] << endl;
+            cout << "   Distorsión:" << endl << calibration->distortionCoefficients[camIdx] << endl;
         }
+        calibration->version++;
+        calibrationLock.unlock();
         
-        // Calibración estereoscópica entre pares de cámaras
-        if (cameraCount >= 2) {
-            performStereoCalibration(0, 1);
-        }
+        // Calibración estereoscópica entre pares de cámaras; con una sola cámara, solo corrección de lente
+        bool calibrated = stereo ? performStereoCalibration(leftCamera, rightCamera, views)
+                                 : configureMonoUndistortion(0);
+        if (!calibrated) return false;
         
         // Bundle Adjustment para optimización global
-        performBundleAdjustment();
+        performBundleAdjustment(views);
+        
+        return true;
+    }
+    
+    /**
+     * Modo monocular: mapas de corrección de distorsión (sin rotación de rectificación) en todos
+     * los niveles, para que la etapa Rectify entregue la imagen sin distorsión en una pasada
+     */
+    bool configureMonoUndistortion(int camIdx) {
+        unique_lock<shared_mutex> calibrationLock(calibration->mutex);
+        const Mat& K = calibration->cameraMatrices[camIdx];
+        if (K.empty()) {
+            cerr << "❌ Cámara " << camIdx << " sin intrínsecos: no se puede corregir la distorsión" << endl;
+            return false;
+        }
+        
+        // alpha = 0: solo píxeles válidos, sin bordes negros
+        Mat newK = getOptimalNewCameraMatrix(K, calibration->distortionCoefficients[camIdx], imageSize, 0.0);
+        calibration->buildRectifyMaps(camIdx, Mat(), newK);
+        calibration->rectifyRotations[camIdx].release();
+        calibration->version++;
+        
+        cout << "✅ Corrección de distorsión monocular configurada (cámara " << camIdx << ")" << endl;
+        return true;
+    }
+    
+    /**
+     * Plano de referencia n·p + offset = 0 en el marco de la cámara (mm), p. ej. mesa o suelo
+     */
+    void setReferencePlane(const Vector3& normal, double offset) {
+        lock_guard<mutex> lock(frameMutex);
+        referencePlane = PlaneFit();
+        if (normal.norm() < 1e-9) return;
+        
+        double scale = 1.0 / normal.norm();
+        referencePlane.normal = normal * scale;
+        referencePlane.offset = offset * scale;
+        referencePlane.valid = true;
+    }
+    
+    /**
+     * Suelo a cameraHeight mm bajo la cámara, con la normal tomada de la gravedad de la IMU
+     */
+    bool setReferencePlaneFromGravity(double cameraHeight) {
+        RigPose pose = fusionEngine->latestPose();
+        if (pose.timestampNs == 0) return false;
+        
+        Vector3 upDevice = pose.orientation.conjugate().rotate(Vector3(0, 0, 1));
+        Vec3d up = imuToCamera * Vec3d(upDevice.x, upDevice.y, upDevice.z);
+        setReferencePlane(Vector3(up[0], up[1], up[2]), cameraHeight);
+        return true;
+    }
+    
+    /**
+     * Medición monocular: solo los píxeles medidos (de la imagen capturada) se corrigen de
+     * distorsión y su rayo se corta con el plano de referencia. Puntos sin corte quedan en NaN.
+     * Los píxeles junto a una esquina se ajustan antes a subpíxel (refined marca los ajustados)
+     */
+    bool measureOnReferencePlane(vector<Point2f>& pixels, vector<Point3d>& points, vector<char>& refined) {
+        int camIdx;
+        PlaneFit plane;
+        Mat grayRegion;
+        Point2f regionOrigin;
+        {
+            lock_guard<mutex> lock(frameMutex);
+            camIdx = min(stereoLeftCamera, cameraCount - 1);
+            plane = referencePlane;
+            
+            // Gris solo de la región que cubren las ventanas de refinamiento
+            if (camIdx >= 0 && frameSlots[camIdx].valid && !pixels.empty()) {
+                const Mat& frame = frameSlots[camIdx].frame;
+                int pad = 2 * pointRefiner.halfWindow() + 2;
+                Rect region = boundingRect(pixels);
+                region = Rect(region.x - pad, region.y - pad, region.width + 2 * pad, region.height + 2 * pad) &
+                         Rect(0, 0, frame.cols, frame.rows);
+                if (region.area() > 0) {
+                    cvtColor(frame(region), grayRegion, COLOR_BGR2GRAY);
+                    regionOrigin = Point2f(float(region.x), float(region.y));
+                }
+            }
+        }
+        points.clear();
+        refined.assign(pixels.size(), 0);
+        if (!plane.valid || camIdx < 0 || pixels.empty()) return false;
+        
+        if (!grayRegion.empty()) {
+            subpixel::PointBatch batch;
+            batch.assign(pixels);
+            for (int i = 0; i < batch.size(); i++) {
+                batch.x[i] -= regionOrigin.x;
+                batch.y[i] -= regionOrigin.y;
+            }
+            threadPool->parallelFor(0, batch.size(), [this, &batch, &grayRegion](int i) {
+                pointRefiner.refine(grayRegion, batch, i, i + 1);
+            });
+            for (int i = 0; i < batch.size(); i++) {
+                if (batch.status[i] != subpixel::Status::Converged) continue;
+                pixels[i] = Point2f(batch.x[i], batch.y[i]) + regionOrigin;
+                refined[i] = 1;
+            }
+        }
+        
+        vector<Point2f> normalized;
+        {
+            shared_lock<shared_mutex> calibrationLock(calibration->mutex);
+            const Mat& K = calibration->cameraMatrices[camIdx];
+            if (K.empty()) return false;
+            undistortPoints(pixels, normalized, K, calibration->distortionCoefficients[camIdx]);
+        }
         
+        points.reserve(normalized.size());
+        for (const auto& point : normalized) {
+            // Rayo (x, y, 1): t = -offset / (n·rayo), válido solo delante de la cámara
+            Vector3 ray(point.x, point.y, 1.0);
+            double denominator = plane.normal.dot(ray);
+            double t = fabs(denominator) > 1e-9 ? -plane.offset / denominator : -1.0;
+            if (t > 0) {
+                points.emplace_back(ray.x * t, ray.y * t, ray.z * t);
+            } else {
+                points.emplace_back(NAN, NAN, NAN);
+            }
+        }
         return true;
     }
     
     /**
      * Calibración estereoscópica exacta con geometría epipolar completa
      */
-    bool performStereoCalibration(int cam1Idx, int cam2Idx) {
+    bool performStereoCalibration(int cam1Idx, int cam2Idx, const vector<vector<vector<Point2f>>>& views) {
         cout << "🔄 Calibración estereoscópica entre cámara " << cam1Idx << " y " << cam2Idx << endl;
         
-        if (imagePointsPerCamera[cam1Idx].empty() || imagePointsPerCamera[cam2Idx].empty()) {
+        if (views[cam1Idx].empty() || views[cam2Idx].empty()) {
             cerr << "❌ Faltan puntos de imagen para calibración estéreo" << endl;
             return false;
         }
@@ -183,53 +940,66 @@ public:
             }
         }
         
-        size_t numImages = min(imagePointsPerCamera[cam1Idx].size(), imagePointsPerCamera[cam2Idx].size());
+        size_t numImages = min(views[cam1Idx].size(), views[cam2Idx].size());
         vector<vector<Point3f>> objectPoints(numImages, patternPoints);
         
         Mat R, T, E, F;
         
-        // Calibración estereoscópica con geometría epipolar exacta
+        unique_lock<shared_mutex> calibrationLock(calibration->mutex);
+        if (calibration->cameraMatrices[cam1Idx].empty() || calibration->cameraMatrices[cam2Idx].empty()) {
+            cerr << "❌ Faltan intrínsecos del par estéreo: no se puede calibrar con CALIB_FIX_INTRINSIC" << endl;
+            return false;
+        }
+        
+        // Calibración estereoscópica con geometría epipolar exacta (vistas emparejadas por índice)
         double rms = stereoCalibrate(
             objectPoints,
-            vector<vector<Point2f>>(imagePointsPerCamera[cam1Idx].begin(), 
-                                  imagePointsPerCamera[cam1Idx].begin() + numImages),
-            vector<vector<Point2f>>(imagePointsPerCamera[cam2Idx].begin(), 
-                                  imagePointsPerCamera[cam2Idx].begin() + numImages),
-            cameraMatrices[cam1Idx], distortionCoefficients[cam1Idx],
-            cameraMatrices[cam2Idx], distortionCoefficients[cam2Idx],
+            vector<vector<Point2f>>(views[cam1Idx].begin(), views[cam1Idx].begin() + numImages),
+            vector<vector<Point2f>>(views[cam2Idx].begin(), views[cam2Idx].begin() + numImages),
+            calibration->cameraMatrices[cam1Idx], calibration->distortionCoefficients[cam1Idx],
+            calibration->cameraMatrices[cam2Idx], calibration->distortionCoefficients[cam2Idx],
             imageSize,
             R, T, E, F,
             CALIB_FIX_INTRINSIC,
             TermCriteria(TermCriteria::COUNT + TermCriteria::EPS, 100, 1e-5)
         );
         
-        rotationMatrices[cam2Idx] = R.clone();
-        translationVectors[cam2Idx] = T.clone();
+        calibration->rotationMatrices[cam2Idx] = R.clone();
+        calibration->translationVectors[cam2Idx] = T.clone();
         
         cout << "📐 Calibración estéreo completada - RMS: " << rms << endl;
         cout << "   Rotación:" << endl << R << endl;
         cout << "   Traslación:" << endl << T << endl;
         
         // Rectificación estereoscópica con compensación epipolar completa
-        Mat R1, R2, P1, P2;
+        Mat R1, R2, P1, P2, Q;
         stereoRectify(
-            cameraMatrices[cam1Idx], distortionCoefficients[cam1Idx],
-            cameraMatrices[cam2Idx], distortionCoefficients[cam2Idx],
+            calibration->cameraMatrices[cam1Idx], calibration->distortionCoefficients[cam1Idx],
+            calibration->cameraMatrices[cam2Idx], calibration->distortionCoefficients[cam2Idx],
             imageSize, R, T,
             R1, R2, P1, P2, Q,
             CALIB_ZERO_DISPARITY,
             1.0, // alpha
             imageSize
         );
-        
-        // Generar mapas de rectificación
-        initUndistortRectifyMap(cameraMatrices[cam1Idx], distortionCoefficients[cam1Idx],
-                               R1, P1, imageSize, CV_16SC2,
-                               rectifyMaps1[cam1Idx], rectifyMaps2[cam1Idx]);
-        
-        initUndistortRectifyMap(cameraMatrices[cam2Idx], distortionCoefficients[cam2Idx],
-                               R2, P2, imageSize, CV_16SC2,
-                               rectifyMaps1[cam2Idx], rectifyMaps2[cam2Idx]);
+        calibration->rectifyRotations[cam1Idx] = R1.clone();
+        calibration->rectifyRotations[cam2Idx] = R2.clone();
+        
+        // Generar mapas de rectificación (y Q) para cada escala de procesamiento
+        calibration->buildRectifyMaps(cam1Idx, R1, P1);
+        calibration->buildRectifyMaps(cam2Idx, R2, P2);
+        calibration->setDisparityToDepth(Q);
+        
+        calibration->version++;
+        calibrationLock.unlock();
+        
+        // El par calibrado define los roles usados por disparidad y triangulación
+        // (frameMutex se toma sin la caché bloqueada para respetar el orden de locks)
+        {
+            lock_guard<mutex> frameLock(frameMutex);
+            stereoLeftCamera = cam1Idx;
+            stereoRightCamera = cam2Idx;
+        }
         
         cout << "✅ Rectificación estereoscópica configurada" << endl;
         
@@ -239,7 +1009,7 @@ public:
     /**
      * Bundle Adjustment para optimización global de parámetros
      */
-    void performBundleAdjustment() {
+    void performBundleAdjustment(const vector<vector<vector<Point2f>>>& views) {
         cout << "🔄 Ejecutando Bundle Adjustment para optimización global..." << endl;
         
         // Implementación de Bundle Adjustment usando algoritmo de Levenberg-Marquardt
@@ -251,11 +1021,13 @@ public:
         // Preparar datos para optimización global
         int totalPoints = 0;
         for (int cam = 0; cam < cameraCount; cam++) {
-            totalPoints += imagePointsPerCamera[cam].size();
+            for (const auto& view : views[cam]) {
+                totalPoints += view.size();
+            }
         }
         
         // Función objetivo para Bundle Adjustment
-        auto residualFunction = [this](const vector<double>& params, vector<double>& residuals) {
+        auto residualFunction = [this, &views](const vector<double>& params, vector<double>& residuals) {
             // Extraer parámetros de cámaras y puntos 3D
             size_t paramIdx = 0;
             
@@ -282,7 +1054,7 @@ public:
             }
             
             // Calcular residuales de reproyección
-            calculateReprojectionResiduals(params, residuals);
+            calculateReprojectionResiduals(views, params, residuals);
         };
         
         cout << "✅ Bundle Adjustment completado - Parámetros optimizados globalmente" << endl;
@@ -297,9 +1069,14 @@ public:
                           const vector<int>& cameraIds) {
         
         unique_lock<mutex> lock(frameMutex);
+        shared_lock<shared_mutex> calibrationLock(calibration->mutex);
         
         cout << "🎯 Procesando " << frameDataList.size() << " frames sincronizados..." << endl;
         
+        if (recorder) {
+            recorder->submit(frameDataList, timestamps, cameraIds, calibration->version);
+        }
+        
         // Verificar sincronización temporal (tolerancia: 16.67ms)
         double maxTimeDiff = 0;
         if (timestamps.size() > 1) {
@@ -311,136 +1088,339 @@ public:
             }
         }
         
-        // Decodificar frames
-        currentFrames.clear();
-        frameTimestamps.clear();
+        // Invalidar ranuras de ingesta sin liberar sus buffers (se reutilizan en la decodificación)
+        for (auto& slot : ingestSlots) {
+            slot.valid = false;
+        }
         
+        // Decodificar frames en la ranura de ingesta de su cámara
         for (size_t i = 0; i < frameDataList.size(); i++) {
-            Mat frame = imdecode(frameDataList[i], IMREAD_COLOR);
-            if (frame.empty()) {
-                cerr << "❌ Error decodificando frame de cámara " << cameraIds[i] << endl;
+            int camIdx = cameraIds[i];
+            if (camIdx < 0 || camIdx >= cameraCount) {
+                cerr << "❌ ID de cámara fuera de rango: " << camIdx << endl;
+                continue;
+            }
+            
+            CameraFrameSlot& slot = ingestSlots[camIdx];
+            imdecode(frameDataList[i], IMREAD_COLOR, &slot.frame);
+            if (slot.frame.empty()) {
+                cerr << "❌ Error decodificando frame de cámara " << camIdx << endl;
                 continue;
             }
             
-            currentFrames[cameraIds[i]] = frame.clone();
-            frameTimestamps[cameraIds[i]] = timestamps[i];
+            slot.timestamp = timestamps[i];
+            slot.valid = true;
+            slot.poseValid = fusionEngine->poseAt(static_cast<int64_t>(timestamps[i] * 1e9), slot.pose);
+            slot.sharpness = measureSharpness(slot.frame);
             
-            cout << "📷 Frame cámara " << cameraIds[i] << ": " << frame.size() 
-                 << " @ " << timestamps[i] << "s" << endl;
+            cout << "📷 Frame cámara " << camIdx << ": " << slot.frame.size() 
+                 << " @ " << timestamps[i] << "s, nitidez " << slot.sharpness << endl;
         }
         
-        // Rectificar frames si la calibración está disponible
-        rectifyFrames();
-        
-        // Generar mapa de disparidad con algoritmo Semi-Global Block Matching
-        if (currentFrames.size() >= 2) {
-            generateStereoDepthMap();
+        // Frames movidos: fuera del modo de vista previa se descartan antes de SGBM/SIFT y
+        // las salidas del último conjunto nítido siguen vigentes (y en caché)
+        if (processingMode != ProcessingMode::PreviewDepth && isMotionBlurred()) {
+            rejectedFrameSets++;
+            cout << "⏭️ Conjunto de frames descartado por desenfoque (" << rejectedFrameSets << " en total)" << endl;
+            return;
         }
         
-        // Detección de características con SIFT
-        detectAndMatchFeatures();
-        
-        // Triangulación 3D exacta
-        perform3DTriangulation();
+        // Nuevo frame: invalida toda salida derivada de los frames anteriores
+        frameId++;
+        validFrameCount = 0;
+        for (int camIdx = 0; camIdx < cameraCount; camIdx++) {
+            swap(frameSlots[camIdx], ingestSlots[camIdx]);
+            if (frameSlots[camIdx].valid) validFrameCount++;
+        }
         
-        // Cálculo de mediciones precisas
-        calculatePreciseMeasurements();
+        // Ejecutar solo las etapas del modo activo, en orden topológico
+        evaluateStages(activeStages);
         
-        cout << "✅ Procesamiento multi-frame completado" << endl;
+        cout << "✅ Procesamiento multi-frame completado (" << processingModeName(processingMode) << ")" << endl;
         cout << "   - Sincronización: ±" << maxTimeDiff * 1000 << "ms" << endl;
-        cout << "   - Frames procesados: " << currentFrames.size() << endl;
+        cout << "   - Frames procesados: " << validFrameCount << endl;
     }
     
     /**
-     * Generación de mapas de profundidad estereoscópicos
-     * Implementa rectificación epipolar completa
+     * Ganancia de exposición de cada cámara respecto a la izquierda: percentiles 5/95 de luma
+     * en la zona común (sin la franja que solo ve una cámara), medidos en los frames de origen
+     * para que la rectificación aplique la corrección en su misma pasada
      */
-    void generateStereoDepthMap() {
-        if (currentFrames.size() < 2) return;
+    void estimateExposureGains() {
+        if (!hasStereoPair()) return;
         
-        auto it = currentFrames.begin();
-        Mat leftFrame = it->second;
-        ++it;
-        Mat rightFrame = it->second;
+        const Mat& reference = frameSlots[stereoLeftCamera].frame;
+        int margin = min(kMaxDisparities, reference.cols / 4);
+        LumaRange referenceRange = measureLumaRange(reference, Rect(margin, 0, reference.cols - margin, reference.rows));
+        photometricGains[stereoLeftCamera] = PhotometricGain();
         
-        cout << "🔄 Generando mapa de disparidad estereoscópico..." << endl;
+        for (int camIdx = 0; camIdx < cameraCount; camIdx++) {
+            if (camIdx == stereoLeftCamera || !frameSlots[camIdx].valid) continue;
+            
+            const Mat& frame = frameSlots[camIdx].frame;
+            LumaRange range = measureLumaRange(frame, Rect(0, 0, frame.cols - margin, frame.rows));
+            photometricGains[camIdx] = photometricGains[camIdx].blended(PhotometricGain::matching(range, referenceRange), 0.3);
+        }
         
-        // Rectificar frames usando mapas precalculados
-        Mat leftRectified, rightRectified;
-        remap(leftFrame, leftRectified, rectifyMaps1[0], rectifyMaps2[0], INTER_LINEAR);
-        remap(rightFrame, rightRectified, rectifyMaps1[1], rectifyMaps2[1], INTER_LINEAR);
+        const PhotometricGain& right = photometricGains[stereoRightCamera];
+        cout << "🎚️ Normalización de exposición cámara " << stereoRightCamera << ": ganancia " 
+             << right.gain << ", offset " << right.offset << endl;
+    }
+    
+    /**
+     * Etapa de disparidad: SGBM sin su filtro de motas (en serie) y limpieza por franjas y
+     * columnas en paralelo; la referencia temporal se toma del mapa ya limpio
+     */
+    PipelineTask computeStereoDisparity() {
+        co_await scheduleOn(*threadPool);
+        if (!generateStereoDepthMap()) co_return;
         
-        // Convertir a escala de grises
-        Mat leftGray, rightGray;
-        cvtColor(leftRectified, leftGray, COLOR_BGR2GRAY);
-        cvtColor(rightRectified, rightGray, COLOR_BGR2GRAY);
+        co_await cleanDisparityMap();
+        storeDisparityReference(disparityMinimum, disparityRange);
+        validateDisparityMap();
+    }
+    
+    /**
+     * Motas por componentes conexas y relleno de huecos pequeños por filas y columnas
+     */
+    PipelineTask cleanDisparityMap() {
+        short invalid = invalidDisparity();
+        int levelArea = 1 << (2 * processingLevel);
+        int maxSpeckleSize = max(16, kSpeckleWindowSize / levelArea);
+        int maxHoleWidth = max(3, kMaxHoleWidth >> processingLevel);
+        
+        speckleFilter.begin(disparityMap, invalid, maxSpeckleSize, kSpeckleRange * 16);
+        co_await forEachBlock(speckleFilter.bandCount(), [this](int band) { speckleFilter.labelBand(band); });
+        speckleFilter.mergeBands();
+        co_await forEachBlock(speckleFilter.bandCount(), [this](int band) { speckleFilter.removeBand(band); });
+        
+        co_await forEachBlock(disparityMap.rows, [this, invalid, maxHoleWidth](int row) {
+            hole_filling::fillRows(disparityMap, invalid, maxHoleWidth, kHoleSurfaceDifference, row, row + 1);
+        });
+        constexpr int columnBlock = 64;
+        int columns = disparityMap.cols;
+        co_await forEachBlock((columns + columnBlock - 1) / columnBlock,
+                              [this, invalid, maxHoleWidth, columns, columnBlock](int block) {
+            hole_filling::fillColumns(disparityMap, invalid, maxHoleWidth, kHoleSurfaceDifference,
+                                      block * columnBlock, min(columns, (block + 1) * columnBlock));
+        });
+        
+        cout << "🧹 Disparidad limpia: " << speckleFilter.removedPixels() << " píxeles de motas eliminados" << endl;
+    }
+    
+    /**
+     * Generación de mapas de profundidad estereoscópicos
+     * Consume los frames ya rectificados por la etapa de rectificación
+     */
+    bool generateStereoDepthMap() {
+        if (!hasStereoPair()) {
+            cout << "⚠️ Falta un frame del par estéreo (" << stereoLeftCamera << "/" 
+                 << stereoRightCamera << "), se omite disparidad" << endl;
+            disparityMap.release();
+            return false;
+        }
+        
+        cout << "🔄 Generando mapa de disparidad estereoscópico..." << endl;
+        
+        // Franja de filas necesaria (a ancho completo para no recortar la búsqueda epipolar)
+        RectifiedTileCache& leftTiles = *rectifiedTiles[stereoLeftCamera];
+        RectifiedTileCache& rightTiles = *rectifiedTiles[stereoRightCamera];
+        Size size = leftTiles.size();
+        Rect band(0, 0, size.width, size.height);
+        if (stereoRegion.area() > 0) {
+            const int pad = 16; // Medio bloque SGBM + margen de filtrado
+            int top = stereoRegion.y >> processingLevel;
+            int bottom = (stereoRegion.y + stereoRegion.height) >> processingLevel;
+            band = Rect(0, top - pad, size.width, bottom - top + 2 * pad) & band;
+        }
+        
+        // Solo se rectifican las teselas de la franja
+        const Mat& leftGray = leftTiles.acquire(band);
+        const Mat& rightGray = rightTiles.acquire(band);
+        
+        // Rango de búsqueda: el de la disparidad del frame anterior llevado con el giroscopio,
+        // sin priori el de las correspondencias dispersas de este par, y si no el completo
+        int minDisparity = 0;
+        int numDisparities = maxDisparities();
+        int sparseSamples = 0;
+        if (disparityPriorFrames < kDisparityPriorFrames && predictDisparityRange(minDisparity, numDisparities)) {
+            disparityPriorFrames++;
+            cout << "🎯 Rango de disparidad predicho por giroscopio: [" << minDisparity << ", " 
+                 << minDisparity + numDisparities << ")" << endl;
+        } else if (sparse_disparity::estimateDisparityRange(leftGray, rightGray, band, disparitySearchLimit(),
+                                                            kDisparityMargin, minDisparity, numDisparities,
+                                                            &sparseSamples)) {
+            disparityPriorFrames = 0;
+            cout << "🎯 Rango de disparidad estimado con " << sparseSamples << " correspondencias: [" 
+                 << minDisparity << ", " << minDisparity + numDisparities << ")" << endl;
+        } else {
+            disparityPriorFrames = 0;
+            minDisparity = 0;
+            numDisparities = maxDisparities();
+        }
         
         // Crear matcher Semi-Global Block Matching (SGBM) para máxima precisión
         auto sgbm = StereoSGBM::create(
-            0,          // minDisparity
-            128,        // numDisparities (múltiplo de 16)
+            minDisparity,
+            numDisparities, // múltiplo de 16
             9,          // blockSize (impar, 3-11)
             600,        // P1 (penalización pequeña de disparidad)
             2400,       // P2 (penalización grande de disparidad)
             20,         // disp12MaxDiff
             16,         // preFilterCap
             2,          // uniquenessRatio
-            200,        // speckleWindowSize
-            25,         // speckleRange
+            0,          // speckleWindowSize (motas: cleanDisparityMap, en paralelo)
+            0,          // speckleRange
             StereoSGBM::MODE_SGBM_3WAY // Algoritmo más preciso
         );
         
         // Generar mapa de disparidad
-        sgbm->compute(leftGray, rightGray, disparityMap);
+        if (band.size() == size) {
+            sgbm->compute(leftGray, rightGray, disparityMap);
+        } else {
+            Mat bandDisparity;
+            sgbm->compute(leftGray(band), rightGray(band), bandDisparity);
+            disparityMap.create(size, CV_16S);
+            disparityMap.setTo(Scalar((minDisparity - 1) * 16)); // Marca de inválido de SGBM
+            bandDisparity.copyTo(disparityMap(band));
+        }
+        disparityMinimum = minDisparity;
+        disparityRange = numDisparities;
+        
+        cout << "✅ Mapa de disparidad generado - Rango: " 
+             << disparityMap.rows << "x" << disparityMap.cols << " (franja " << band.height << " filas, "
+             << leftTiles.rectifiedTileCount() << "/" << leftTiles.tileCount() << " teselas rectificadas)" << endl;
+        return true;
+    }
+    
+    /**
+     * Conversión de disparidad a profundidad real usando matriz Q
+     */
+    void reprojectDisparityToDepth() {
+        if (disparityMap.empty()) {
+            depthMap.release();
+            return;
+        }
         
-        // Convertir disparidad a profundidad real usando matriz Q
-        reprojectImageTo3D(disparityMap, depthMap, Q, true);
+        reprojectImageTo3D(disparityMap, depthMap, calibration->pyramidQ[processingLevel], true);
+    }
+    
+    /**
+     * Filtrado bilateral para suavizar preservando bordes
+     */
+    void filterDepthMap() {
+        if (depthMap.empty()) return;
         
-        // Filtrado bilateral para suavizar preservando bordes
         Mat depthFiltered;
         bilateralFilter(depthMap, depthFiltered, 9, 75, 75);
         depthMap = depthFiltered;
+    }
+    
+    /**
+     * Detección de características con SIFT en una cámara
+     */
+    void detectFeatures(int camIdx) {
+        frameKeypoints[camIdx].clear();
+        frameDescriptors[camIdx].release();
         
-        cout << "✅ Mapa de disparidad generado - Rango: " 
-             << disparityMap.rows << "x" << disparityMap.cols << endl;
-        
-        // Validar calidad del mapa de disparidad
-        validateDisparityMap();
+        Mat& grayFrame = featureGrays[camIdx];
+        cvtColor(frameSlots[camIdx].frame, grayFrame, COLOR_BGR2GRAY);
+        siftDetector->detectAndCompute(grayFrame, noArray(), frameKeypoints[camIdx], frameDescriptors[camIdx]);
     }
     
     /**
-     * Detección y emparejamiento de características con SIFT
+     * Seguimiento KLT de la cámara izquierda. Con pose IMU en ambos frames, los puntos se
+     * desplazan primero por la homografía de rotación del giroscopio y la búsqueda se reduce
+     * a una ventana pequeña en un solo nivel de pirámide
      */
-    void detectAndMatchFeatures() {
-        cout << "🔄 Detectando características con SIFT..." << endl;
+    void trackFeatures() {
+        if (!hasStereoPair()) {
+            trackedPoints.clear();
+            trackingReference = TemporalReference();
+            return;
+        }
+        
+        const CameraFrameSlot& slot = frameSlots[stereoLeftCamera];
+        const Mat& gray = rectifiedTiles[stereoLeftCamera]->acquire();
         
-        vector<vector<KeyPoint>> allKeypoints(currentFrames.size());
-        vector<Mat> allDescriptors(currentFrames.size());
+        bool referenceUsable = !trackingReference.data.empty() && !trackedPoints.empty() &&
+                               trackingReference.data.size() == gray.size() &&
+                               trackingReference.calibrationVersion == calibration->version;
         
-        int frameIdx = 0;
-        for (const auto& framePair : currentFrames) {
-            Mat grayFrame;
-            cvtColor(framePair.second, grayFrame, COLOR_BGR2GRAY);
+        if (referenceUsable) {
+            vector<Point2f> predicted = trackedPoints;
+            Matx33d homography;
+            bool gyroPredicted = slot.poseValid && trackingReference.poseValid &&
+                                 predictRotationHomography(trackingReference.pose, slot.pose, homography);
+            if (gyroPredicted) {
+                perspectiveTransform(trackedPoints, predicted, Mat(homography));
+            }
             
-            // Detección de características SIFT
-            vector<KeyPoint> keypoints;
-            Mat descriptors;
+            vector<uchar> status;
+            vector<float> error;
+            calcOpticalFlowPyrLK(trackingReference.data, gray, trackedPoints, predicted, status, error,
+                                 gyroPredicted ? Size(11, 11) : Size(21, 21),
+                                 gyroPredicted ? 1 : 3,
+                                 TermCriteria(TermCriteria::COUNT + TermCriteria::EPS, 20, 0.03),
+                                 gyroPredicted ? OPTFLOW_USE_INITIAL_FLOW : 0);
             
-            siftDetector->detectAndCompute(grayFrame, noArray(), keypoints, descriptors);
+            Rect bounds(0, 0, gray.cols, gray.rows);
+            size_t kept = 0;
+            for (size_t i = 0; i < predicted.size(); i++) {
+                if (status[i] && bounds.contains(Point(predicted[i]))) {
+                    predicted[kept++] = predicted[i];
+                }
+            }
+            predicted.resize(kept);
             
-            allKeypoints[frameIdx] = keypoints;
-            allDescriptors[frameIdx] = descriptors;
+            cout << "🔁 KLT" << (gyroPredicted ? " (predicción giroscopio)" : "") << ": " 
+                 << kept << "/" << trackedPoints.size() << " puntos seguidos" << endl;
+            trackedPoints.swap(predicted);
+        } else {
+            trackedPoints.clear();
+        }
+        
+        // Re-detección solo cuando se pierden demasiados puntos, lejos de los ya seguidos
+        if (static_cast<int>(trackedPoints.size()) < kMinTrackedFeatures) {
+            Mat mask(gray.size(), CV_8U, Scalar(255));
+            for (const auto& point : trackedPoints) {
+                circle(mask, point, 10, Scalar(0), FILLED);
+            }
             
-            cout << "📍 Cámara " << framePair.first << ": " << keypoints.size() 
+            vector<Point2f> fresh;
+            goodFeaturesToTrack(gray, fresh, kMaxTrackedFeatures - static_cast<int>(trackedPoints.size()), 0.01, 10, mask);
+            trackedPoints.insert(trackedPoints.end(), fresh.begin(), fresh.end());
+            cout << "📍 KLT re-detección: " << fresh.size() << " puntos nuevos" << endl;
+        }
+        
+        gray.copyTo(trackingReference.data); // El buffer de gris se reescribe en el frame siguiente
+        trackingReference.pose = slot.pose;
+        trackingReference.poseValid = slot.poseValid;
+        trackingReference.calibrationVersion = calibration->version;
+    }
+    
+    void logDetectedFeatures() const {
+        for (int camIdx = 0; camIdx < cameraCount; camIdx++) {
+            if (!frameSlots[camIdx].valid) continue;
+            cout << "📍 Cámara " << camIdx << ": " << frameKeypoints[camIdx].size() 
                  << " características SIFT detectadas" << endl;
-            
-            frameIdx++;
         }
+    }
+    
+    /**
+     * Emparejamiento de descriptores entre las cámaras del par estéreo
+     */
+    void matchFeatures() {
+        matchedPointsLeft.clear();
+        matchedPointsRight.clear();
         
-        // Emparejamiento entre pares de frames
-        if (allDescriptors.size() >= 2 && !allDescriptors[0].empty() && !allDescriptors[1].empty()) {
+        if (hasStereoPair() && !frameDescriptors[stereoLeftCamera].empty() && 
+            !frameDescriptors[stereoRightCamera].empty()) {
             vector<DMatch> matches;
-            matcher->match(allDescriptors[0], allDescriptors[1], matches);
+            if ((featureMatchMode != FeatureMatchMode::DisparityGuided || !matchFeaturesGuided(matches)) &&
+                (!compactDescriptorsEnabled || !matchFeaturesCompact(matches))) {
+                matcher->match(frameDescriptors[stereoLeftCamera], frameDescriptors[stereoRightCamera], matches);
+            }
             
             // Filtrar matches usando test de ratio de Lowe
             vector<DMatch> goodMatches;
@@ -453,8 +1433,88 @@ public:
             cout << "🔗 " << goodMatches.size() << " matches de alta calidad encontrados" << endl;
             
             // Guardar matches para triangulación 3D
-            storeMatchesForTriangulation(allKeypoints[0], allKeypoints[1], goodMatches);
+            storeMatchesForTriangulation(frameKeypoints[stereoLeftCamera], frameKeypoints[stereoRightCamera], goodMatches);
+        }
+    }
+    
+    /**
+     * Emparejamiento guiado: keypoints de ambas cámaras a coordenadas rectificadas con la malla
+     * y búsqueda solo alrededor de la posición que predice la disparidad SGBM.
+     * false sin disparidad o sin rectificación (se empareja por fuerza bruta)
+     */
+    bool matchFeaturesGuided(vector<DMatch>& matches) {
+        const KeypointUndistortGrid& leftGrid = calibration->keypointGrids[stereoLeftCamera];
+        const KeypointUndistortGrid& rightGrid = calibration->keypointGrids[stereoRightCamera];
+        if (disparityMap.empty() || leftGrid.empty() || rightGrid.empty()) return false;
+        
+        vector<Point2f> rawLeft, rawRight, rectifiedLeft, rectifiedRight;
+        KeyPoint::convert(frameKeypoints[stereoLeftCamera], rawLeft);
+        KeyPoint::convert(frameKeypoints[stereoRightCamera], rawRight);
+        leftGrid.apply(rawLeft, rectifiedLeft);
+        rightGrid.apply(rawRight, rectifiedRight);
+        
+        GuidedStereoMatcher::Statistics statistics;
+        guidedMatcher.setDisparity(disparityMap, processingLevel, invalidDisparity());
+        if (!guidedMatcher.match(rectifiedLeft, rectifiedRight, frameDescriptors[stereoLeftCamera],
+                                 frameDescriptors[stereoRightCamera], matches, statistics)) {
+            return false;
+        }
+        
+        cout << "🧭 Emparejamiento guiado por disparidad: " << statistics.predicted << " predicciones, "
+             << statistics.comparisons << " comparaciones (fuerza bruta: "
+             << frameKeypoints[stereoLeftCamera].size() * frameKeypoints[stereoRightCamera].size() << ")" << endl;
+        return true;
+    }
+    
+    /**
+     * Emparejamiento con descriptores compactos; la primera vez entrena la base PCA con los
+     * descriptores de ambas cámaras. false si aún no hay base (se usa la fuerza bruta float)
+     */
+    bool matchFeaturesCompact(vector<DMatch>& matches) {
+        const Mat& left = frameDescriptors[stereoLeftCamera];
+        const Mat& right = frameDescriptors[stereoRightCamera];
+        
+        if (!compactMatcher.hasBasis()) {
+            Mat samples;
+            vconcat(left, right, samples);
+            if (!compactMatcher.train(samples)) return false;
+            cout << "🧮 Base PCA de descriptores entrenada con " << samples.rows << " muestras ("
+                 << compact_descriptors::kDimensions << " dimensiones int8)" << endl;
+        }
+        return compactMatcher.match(left, right, matches);
+    }
+    
+    /**
+     * Triangulación sobre correspondencias subpíxel: los keypoints de ambas cámaras se
+     * refinan como dos lotes concurrentes antes de la DLT
+     */
+    PipelineTask triangulateRefinedMatches() {
+        refinedPointsLeft = matchedPointsLeft;
+        refinedPointsRight = matchedPointsRight;
+        if (hasStereoPair() && !featureGrays[stereoLeftCamera].empty() && !featureGrays[stereoRightCamera].empty()) {
+            int converged[2] = {0, 0};
+            vector<PipelineTask> perCamera;
+            perCamera.push_back(refinePoints(featureGrays[stereoLeftCamera], refinedPointsLeft, converged[0]));
+            perCamera.push_back(refinePoints(featureGrays[stereoRightCamera], refinedPointsRight, converged[1]));
+            co_await whenAll(std::move(perCamera));
+            
+            cout << "🔬 Correspondencias refinadas a subpíxel: " << converged[0] << "/" << refinedPointsLeft.size()
+                 << " izquierda, " << converged[1] << "/" << refinedPointsRight.size() << " derecha" << endl;
         }
+        
+        co_await scheduleOn(*threadPool);
+        perform3DTriangulation();
+    }
+    
+    /**
+     * Lote de puntos sobre un gris, repartido entre los hilos del pool
+     */
+    PipelineTask refinePoints(const Mat& gray, vector<Point2f>& points, int& converged) {
+        subpixel::PointBatch batch;
+        batch.assign(points);
+        co_await forEachBlock(batch.size(), [this, &batch, &gray](int i) { pointRefiner.refine(gray, batch, i, i + 1); });
+        batch.store(points);
+        converged = batch.count(subpixel::Status::Converged);
     }
     
     /**
@@ -462,8 +1522,10 @@ public:
      */
     void perform3DTriangulation() {
         cout << "🔄 Realizando triangulación 3D exacta..." << endl;
+        triangulatedPoints.clear();
+        triangulationErrors.clear();
         
-        if (currentFrames.size() < 2) {
+        if (!hasStereoPair()) {
             cout << "⚠️ Se requieren al menos 2 cámaras para triangulación 3D" << endl;
             return;
         }
@@ -479,11 +1541,25 @@ public:
         
         // Matrices de proyección para triangulación
         Mat P1, P2;
-        hconcat(cameraMatrices[0], Mat::zeros(3, 1, CV_64F), P1);
-        
-        Mat RT;
-        hconcat(rotationMatrices[1], translationVectors[1], RT);
-        P2 = cameraMatrices[1] * RT;
+        const KeypointUndistortGrid& leftGrid = calibration->keypointGrids[stereoLeftCamera];
+        const KeypointUndistortGrid& rightGrid = calibration->keypointGrids[stereoRightCamera];
+        if (!leftGrid.empty() && !rightGrid.empty() && calibration->rectifyProjections[stereoRightCamera].cols == 4) {
+            // Keypoints de la imagen en bruto corregidos con la malla (sin remap de imagen):
+            // P1/P2 rectificadas, puntos 3D en el marco rectificado izquierdo (el de la matriz Q)
+            vector<Point2f> rectified1, rectified2;
+            leftGrid.apply(points1, rectified1);
+            rightGrid.apply(points2, rectified2);
+            points1.swap(rectified1);
+            points2.swap(rectified2);
+            P1 = calibration->rectifyProjections[stereoLeftCamera];
+            P2 = calibration->rectifyProjections[stereoRightCamera];
+        } else {
+            hconcat(calibration->cameraMatrices[stereoLeftCamera], Mat::zeros(3, 1, CV_64F), P1);
+            
+            Mat RT;
+            hconcat(calibration->rotationMatrices[stereoRightCamera], calibration->translationVectors[stereoRightCamera], RT);
+            P2 = calibration->cameraMatrices[stereoRightCamera] * RT;
+        }
         
         // Triangulación usando método DLT (Direct Linear Transform)
         Mat points4D;
@@ -503,7 +1579,7 @@ public:
         cout << "✅ " << points3D.size() << " puntos 3D triangulados exitosamente" << endl;
         
         // Validar calidad de triangulación
-        validateTriangulation(points3D, points1, points2);
+        validateTriangulation(points3D, points1, points2, P1, P2);
         
         // Almacenar puntos 3D para mediciones
         store3DPoints(points3D);
@@ -518,37 +1594,610 @@ public:
         // Implementar cálculos exactos sin aproximaciones
         // Análisis de propagación de errores para estimación de incertidumbre
         
+        depthStatistics = DepthStatistics();
+        
         if (!depthMap.empty()) {
-            // Análisis estadístico del mapa de profundidad
-            Scalar meanDepth, stdDepth;
-            meanStdDev(depthMap, meanDepth, stdDepth);
+            // measurementRoi está a resolución completa y depthMap a 1/2^processingLevel:
+            // se escala como stereoRegion, redondeando el final hacia fuera
+            Rect roi(0, 0, depthMap.cols, depthMap.rows);
+            if (measurementRoi.area() > 0) {
+                int round = (1 << processingLevel) - 1;
+                int left = measurementRoi.x >> processingLevel;
+                int top = measurementRoi.y >> processingLevel;
+                int right = (measurementRoi.x + measurementRoi.width + round) >> processingLevel;
+                int bottom = (measurementRoi.y + measurementRoi.height + round) >> processingLevel;
+                roi &= Rect(left, top, right - left, bottom - top);
+            }
+            
+            // Con las integrales del frame ya construidas (normales pedidas), 4 accesos; si no,
+            // solo la Z de la región, excluyendo el centinela de reprojectImageTo3D (Z = 10000)
+            if (depthIntegralsReady.load(memory_order_acquire) == depthIntegralsVersion()) {
+                DepthIntegralImages::WindowSums sums = depthIntegrals.window(roi);
+                if (sums.count > 0) {
+                    double meanDepth = sums.sum[2] / sums.count;
+                    double stdDepth = sqrt(max(0.0, sums.sumSquaredZ / sums.count - meanDepth * meanDepth));
+                    
+                    depthStatistics.meanDepth = meanDepth;
+                    depthStatistics.stdDepth = stdDepth;
+                    depthStatistics.uncertainty95 = stdDepth * 1.96;
+                }
+                depthStatistics.validPixels = sums.count;
+            } else {
+                Mat depthZ;
+                extractChannel(depthMap(roi), depthZ, 2);
+                Mat validMask = (depthZ > 0) & (depthZ < DepthIntegralImages::kMaxDepth);
+                
+                Scalar meanDepth, stdDepth;
+                meanStdDev(depthZ, meanDepth, stdDepth, validMask);
+                
+                depthStatistics.meanDepth = meanDepth[0];
+                depthStatistics.stdDepth = stdDepth[0];
+                depthStatistics.uncertainty95 = stdDepth[0] * 1.96;
+                depthStatistics.validPixels = countNonZero(validMask);
+            }
             
             cout << "📊 Estadísticas de profundidad:" << endl;
-            cout << "   - Profundidad media: " << meanDepth[0] << "mm" << endl;
-            cout << "   - Desviación estándar: " << stdDepth[0] << "mm" << endl;
-            cout << "   - Incertidumbre estimada: ±" << stdDepth[0] * 1.96 << "mm (95% confianza)" << endl;
+            cout << "   - Profundidad media: " << depthStatistics.meanDepth << "mm" << endl;
+            cout << "   - Desviación estándar: " << depthStatistics.stdDepth << "mm" << endl;
+            cout << "   - Incertidumbre estimada: ±" << depthStatistics.uncertainty95 << "mm (95% confianza)" << endl;
         }
         
         cout << "✅ Mediciones precisas calculadas con análisis de incertidumbre" << endl;
     }
     
+    /**
+     * Plano dominante en la nube de profundidad con la vertical de la IMU en el instante del frame.
+     * Fijar la normal reduce la muestra mínima a 1 punto (horizontal) o 2 (vertical)
+     */
+    void detectGravityAlignedPlane() {
+        dominantPlane = PlaneFit();
+        
+        if (depthMap.empty() || !hasStereoPair() || !frameSlots[stereoLeftCamera].poseValid) {
+            cout << "⚠️ Sin profundidad o pose IMU para el frame: detección de plano omitida" << endl;
+            return;
+        }
+        const CameraFrameSlot& slot = frameSlots[stereoLeftCamera];
+        
+        // Vertical del mundo en ejes del dispositivo, luego de la cámara y del marco rectificado
+        Vector3 upDevice = slot.pose.orientation.conjugate().rotate(Vector3(0, 0, 1));
+        Vec3d up = imuToCamera * Vec3d(upDevice.x, upDevice.y, upDevice.z);
+        const Mat& rectifyRotation = calibration->rectifyRotations[stereoLeftCamera];
+        if (!rectifyRotation.empty()) {
+            up = Matx33d(rectifyRotation) * up;
+        }
+        
+        // Submuestreo regular de la nube (RANSAC no necesita todos los píxeles)
+        const int maxPoints = 20000;
+        int step = max(1, int(sqrt(double(depthMap.total()) / maxPoints)));
+        vector<Vector3> points;
+        points.reserve(maxPoints + depthMap.cols);
+        for (int y = 0; y < depthMap.rows; y += step) {
+            const Vec3f* row = depthMap.ptr<Vec3f>(y);
+            for (int x = 0; x < depthMap.cols; x += step) {
+                const Vec3f& p = row[x];
+                if (p[2] > 0 && p[2] < 10000 && isfinite(p[0]) && isfinite(p[1])) {
+                    points.emplace_back(p[0], p[1], p[2]);
+                }
+            }
+        }
+        
+        dominantPlane = PlaneDetector::detect(points, Vector3(up[0], up[1], up[2]), planeOrientation, planeSearchParams);
+        
+        if (dominantPlane.valid) {
+            cout << "🧱 Plano " << (planeOrientation == PlaneOrientation::Horizontal ? "horizontal" : "vertical")
+                 << ": distancia " << fabs(dominantPlane.offset) << "mm, " << dominantPlane.inliers << "/"
+                 << points.size() << " inliers en " << dominantPlane.iterations << " iteraciones" << endl;
+        } else {
+            cout << "⚠️ Ningún plano compatible con la gravedad" << endl;
+        }
+    }
+    
     // Métodos auxiliares privados
     
 private:
-    void rectifyFrames() {
-        for (auto& framePair : currentFrames) {
-            int camIdx = framePair.first;
-            if (camIdx < rectifyMaps1.size() && !rectifyMaps1[camIdx].empty()) {
-                Mat rectified;
-                remap(framePair.second, rectified, rectifyMaps1[camIdx], rectifyMaps2[camIdx], INTER_LINEAR);
-                processedFrames[camIdx] = rectified;
-            } else {
-                processedFrames[camIdx] = framePair.second.clone();
+    /**
+     * Ejecuta las etapas de la máscara cuya versión de entradas cambió desde su último cálculo.
+     * El hilo llamador (JNI) espera; el trabajo corre como corrutinas en el pool
+     */
+    int evaluateStages(StageMask stages) {
+        int recomputed = 0;
+        syncWait(evaluateStagesAsync(stages, recomputed));
+        return recomputed;
+    }
+    
+    /**
+     * Recorrido del grafo por niveles: las etapas obsoletas de un mismo nivel
+     * (p.ej. SGBM y emparejamiento SIFT) corren concurrentemente y se unen sin bloquear hilos
+     */
+    PipelineTask evaluateStagesAsync(StageMask stages, int& recomputed) {
+        int maxLevel = *max_element(stageLevels.begin(), stageLevels.end());
+        
+        for (int level = 0; level <= maxLevel; level++) {
+            vector<PipelineTask> pending;
+            
+            for (const auto& descriptor : stageDescriptors()) {
+                int stageIdx = static_cast<int>(descriptor.stage);
+                if (!(stages & stageBit(descriptor.stage)) || stageLevels[stageIdx] != level) continue;
+                
+                // Las entradas pertenecen a niveles anteriores, ya resueltos
+                StageVersion version = stageSourceVersion(descriptor.stage);
+                for (int inputIdx = 0; inputIdx < stageIdx; inputIdx++) {
+                    if (stageInputs[stageIdx] & (StageMask(1) << inputIdx)) {
+                        version = mixVersion(version, stageVersions[inputIdx]);
+                    }
+                }
+                
+                if (version == stageVersions[stageIdx]) continue; // Acierto de caché
+                
+                pending.push_back(runStageAsync(descriptor.stage));
+                stageVersions[stageIdx] = version;
+                recomputed++;
+            }
+            
+            co_await whenAll(std::move(pending));
+        }
+    }
+    
+    /**
+     * Etapas por cámara se reparten en una tarea por cámara; el resto corre como una tarea
+     */
+    PipelineTask runStageAsync(PipelineStage stage) {
+        switch (stage) {
+            case PipelineStage::Rectify:
+                co_await forEachCamera([this](int camIdx) { rectifyFrame(camIdx); });
+                break;
+            case PipelineStage::FeatureDetect:
+                cout << "🔄 Detectando características con SIFT..." << endl;
+                co_await forEachCamera([this](int camIdx) { detectFeatures(camIdx); });
+                logDetectedFeatures();
+                break;
+            case PipelineStage::CalibrationCorners:
+                co_await forEachCamera([this](int camIdx) { detectCalibrationCorners(camIdx); });
+                co_await refineCalibrationCorners();
+                accumulateCalibrationCorners();
+                break;
+            case PipelineStage::SurfaceMesh:
+                co_await buildSurfaceMesh();
+                break;
+            case PipelineStage::Triangulate:
+                co_await triangulateRefinedMatches();
+                break;
+            case PipelineStage::StereoMatch:
+                co_await computeStereoDisparity();
+                break;
+            case PipelineStage::DepthIntegrals:
+                co_await buildDepthIntegrals();
+                break;
+            case PipelineStage::SurfaceNormals:
+                co_await estimateSurfaceNormals();
+                break;
+            default:
+                co_await scheduleOn(*threadPool);
+                runStage(stage);
+                break;
+        }
+    }
+    
+    PipelineTask forEachCamera(function<void(int)> body) {
+        vector<PipelineTask> perCamera;
+        for (int camIdx = 0; camIdx < cameraCount; camIdx++) {
+            if (frameSlots[camIdx].valid) {
+                perCamera.push_back(runCameraTask(body, camIdx));
+            }
+        }
+        co_await whenAll(std::move(perCamera));
+    }
+    
+    PipelineTask runCameraTask(const function<void(int)>& body, int camIdx) {
+        co_await scheduleOn(*threadPool);
+        body(camIdx);
+    }
+    
+    /**
+     * body(i) para i en [0, count) repartido en un bloque contiguo por hilo del pool
+     */
+    PipelineTask forEachBlock(int count, function<void(int)> body) {
+        int chunks = min<int>(count, int(threadPool->size()));
+        if (chunks <= 0) co_return;
+        
+        int chunkSize = (count + chunks - 1) / chunks;
+        vector<PipelineTask> perChunk;
+        for (int begin = 0; begin < count; begin += chunkSize) {
+            perChunk.push_back(runBlockTask(body, begin, min(count, begin + chunkSize)));
+        }
+        co_await whenAll(std::move(perChunk));
+    }
+    
+    PipelineTask runBlockTask(const function<void(int)>& body, int begin, int end) {
+        co_await scheduleOn(*threadPool);
+        for (int i = begin; i < end; i++) {
+            body(i);
+        }
+    }
+    
+    /**
+     * Integrales de la profundidad: sumas por fila y acumulación por bloques de columnas en paralelo
+     */
+    PipelineTask buildDepthIntegrals() {
+        depthIntegralsReady.store(kStageNeverComputed, memory_order_relaxed);
+        if (depthMap.empty()) {
+            depthIntegrals.release();
+            co_return;
+        }
+        
+        depthIntegrals.begin(depthMap);
+        co_await forEachBlock(depthMap.rows, [this](int row) { depthIntegrals.accumulateRows(row, row + 1); });
+        
+        constexpr int columnBlock = 64;
+        int columns = depthMap.cols + 1;
+        co_await forEachBlock((columns + columnBlock - 1) / columnBlock, [this, columns, columnBlock](int block) {
+            depthIntegrals.accumulateColumns(block * columnBlock, min(columns, (block + 1) * columnBlock));
+        });
+        depthIntegralsReady.store(depthIntegralsVersion(), memory_order_release);
+    }
+    
+    /**
+     * Versión que tendrían las integrales construidas sobre la profundidad filtrada actual
+     * (misma combinación que evaluateStagesAsync)
+     */
+    StageVersion depthIntegralsVersion() const {
+        return mixVersion(stageSourceVersion(PipelineStage::DepthIntegrals),
+                          stageVersions[static_cast<int>(PipelineStage::DepthFilter)]);
+    }
+    
+    /**
+     * Normales por gradiente 3D medio, en paralelo por filas (radio escalado al nivel de la pirámide)
+     */
+    PipelineTask estimateSurfaceNormals() {
+        if (depthIntegrals.empty()) {
+            normalMap.release();
+            co_return;
+        }
+        
+        normalMap.create(depthIntegrals.size(), CV_32FC3);
+        int radius = max(2, kNormalWindowRadius >> processingLevel);
+        co_await forEachBlock(normalMap.rows, [this, radius](int row) {
+            depthIntegrals.estimateNormals(normalMap, radius, row, row + 1);
+        });
+    }
+    
+    /**
+     * Malla de la profundidad: análisis, selección de hojas y triangulación por teselas en
+     * paralelo; la elección de tolerancia y la numeración de vértices compartidos, en serie
+     */
+    PipelineTask buildSurfaceMesh() {
+        surfaceMesh.clear();
+        if (depthMap.empty()) co_return;
+        
+        depthMesher.begin(depthMap);
+        int tiles = depthMesher.tileCount();
+        co_await forEachBlock(tiles, [this](int tile) { depthMesher.analyzeTile(tile); });
+        depthMesher.chooseTolerance(meshTriangleBudget);
+        co_await forEachBlock(tiles, [this](int tile) { depthMesher.collectLeaves(tile); });
+        depthMesher.indexVertices();
+        co_await forEachBlock(tiles, [this](int tile) { depthMesher.triangulateTile(tile); });
+        depthMesher.assemble(surfaceMesh);
+        
+        cout << "🔺 Malla: " << surfaceMesh.vertices.size() << " vértices, " << surfaceMesh.triangles.size()
+             << " triángulos (tolerancia " << depthMesher.tolerance() * 100 << "%)" << endl;
+    }
+    
+    /**
+     * Fuentes externas de cada etapa: frame, calibración, par estéreo y parámetros propios
+     */
+    StageVersion stageSourceVersion(PipelineStage stage) const {
+        int stageIdx = static_cast<int>(stage);
+        StageVersion version = mixVersion(stageIdx + 1, stageParameterVersions[stageIdx]);
+        
+        switch (stage) {
+            case PipelineStage::Rectify:
+                version = mixVersion(version, frameId);
+                version = mixVersion(version, calibration->version);
+                version = mixVersion(version, uint64_t(processingLevel));
+                break;
+            case PipelineStage::FeatureDetect:
+            case PipelineStage::CalibrationCorners:
+                version = mixVersion(version, frameId);
+                break;
+            case PipelineStage::ExposureMatch:
+                version = mixVersion(version, frameId);
+                version = mixVersion(version, (uint64_t(stereoLeftCamera) << 32) | uint32_t(stereoRightCamera));
+                break;
+            case PipelineStage::StereoMatch:
+            case PipelineStage::FeatureMatch:
+            case PipelineStage::FeatureTrack:
+                version = mixVersion(version, (uint64_t(stereoLeftCamera) << 32) | uint32_t(stereoRightCamera));
+                break;
+            case PipelineStage::Reproject:
+            case PipelineStage::Triangulate:
+            case PipelineStage::PlaneDetect:
+                version = mixVersion(version, calibration->version);
+                break;
+            case PipelineStage::DepthFilter:
+            case PipelineStage::DepthIntegrals:
+            case PipelineStage::DepthStatistics:
+            case PipelineStage::SurfaceMesh:
+            case PipelineStage::Count:
+                break;
+            case PipelineStage::SurfaceNormals:
+                version = mixVersion(version, uint64_t(processingLevel));
+                break;
+        }
+        
+        return version;
+    }
+    
+    /**
+     * Etapas de frame completo (las etapas por cámara se despachan en runStageAsync)
+     */
+    void runStage(PipelineStage stage) {
+        switch (stage) {
+            case PipelineStage::ExposureMatch:      estimateExposureGains(); break;
+            case PipelineStage::Reproject:          reprojectDisparityToDepth(); break;
+            case PipelineStage::DepthFilter:        filterDepthMap(); break;
+            case PipelineStage::FeatureMatch:       matchFeatures(); break;
+            case PipelineStage::FeatureTrack:       trackFeatures(); break;
+            case PipelineStage::DepthStatistics:    calculatePreciseMeasurements(); break;
+            case PipelineStage::PlaneDetect:        detectGravityAlignedPlane(); break;
+            case PipelineStage::Rectify:
+            case PipelineStage::StereoMatch:
+            case PipelineStage::FeatureDetect:
+            case PipelineStage::CalibrationCorners:
+            case PipelineStage::DepthIntegrals:
+            case PipelineStage::SurfaceNormals:
+            case PipelineStage::SurfaceMesh:
+            case PipelineStage::Triangulate:
+            case PipelineStage::Count:              break;
+        }
+    }
+    
+    /**
+     * Detección de esquinas del tablero 9x6 en una cámara
+     */
+    void detectCalibrationCorners(int camIdx) {
+        Size patternSize(9, 6);
+        vector<Point2f>& corners = calibrationCorners[camIdx];
+        corners.clear();
+        
+        Mat& grayFrame = calibrationGrays[camIdx];
+        cvtColor(frameSlots[camIdx].frame, grayFrame, COLOR_BGR2GRAY);
+        calibrationCornersFound[camIdx] = findChessboardCorners(grayFrame, patternSize, corners,
+                                                                CALIB_CB_ADAPTIVE_THRESH | CALIB_CB_NORMALIZE_IMAGE);
+    }
+    
+    /**
+     * Refinamiento subpíxel de las esquinas encontradas, cada cámara como un lote repartido
+     * entre los hilos. Las esquinas que no convergen conservan la posición del detector
+     */
+    PipelineTask refineCalibrationCorners() {
+        subpixel::PointBatch batch;
+        for (int camIdx = 0; camIdx < cameraCount; camIdx++) {
+            if (!frameSlots[camIdx].valid || !calibrationCornersFound[camIdx]) continue;
+            
+            batch.assign(calibrationCorners[camIdx]);
+            const Mat& gray = calibrationGrays[camIdx];
+            co_await forEachBlock(batch.size(), [this, &batch, &gray](int i) { cornerRefiner.refine(gray, batch, i, i + 1); });
+            batch.store(calibrationCorners[camIdx]);
+        }
+    }
+    
+    /**
+     * Acumulación de la vista de calibración.
+     * Solo se acumula si el patrón aparece en todas las cámaras, para mantener las vistas emparejadas
+     */
+    void accumulateCalibrationCorners() {
+        for (int camIdx = 0; camIdx < cameraCount; camIdx++) {
+            if (frameSlots[camIdx].valid && !calibrationCornersFound[camIdx]) {
+                cout << "⚠️ Patrón no visible en cámara " << camIdx << ", vista descartada" << endl;
+                return;
             }
         }
+        
+        for (int camIdx = 0; camIdx < cameraCount; camIdx++) {
+            if (!frameSlots[camIdx].valid) continue;
+            imagePointsPerCamera[camIdx].push_back(calibrationCorners[camIdx]);
+        }
+        
+        cout << "📐 Vista de calibración capturada en " << validFrameCount << " cámaras" << endl;
+    }
+    
+    bool hasStereoPair() const {
+        return stereoLeftCamera != stereoRightCamera &&
+               stereoLeftCamera < cameraCount && stereoRightCamera < cameraCount &&
+               frameSlots[stereoLeftCamera].valid && frameSlots[stereoRightCamera].valid;
+    }
+    
+    /**
+     * Homografía de rotación pura H = K·R·K⁻¹ entre dos poses IMU, en el marco rectificado
+     * de la cámara izquierda (K se obtiene de Q). Falso sin calibración estéreo
+     */
+    bool predictRotationHomography(const RigPose& from, const RigPose& to, Matx33d& homography) const {
+        const Mat& Q = calibration->pyramidQ[processingLevel];
+        if (Q.empty()) return false;
+        
+        double focal = Q.at<double>(2, 3);
+        Matx33d K(focal, 0, -Q.at<double>(0, 3),
+                  0, focal, -Q.at<double>(1, 3),
+                  0, 0, 1);
+        
+        // Rotación de ejes del dispositivo del frame anterior al actual
+        Quaternion relative = to.orientation.conjugate() * from.orientation;
+        Matx33d deviceRotation;
+        for (int c = 0; c < 3; c++) {
+            Vector3 axis = relative.rotate(Vector3(c == 0, c == 1, c == 2));
+            deviceRotation(0, c) = axis.x;
+            deviceRotation(1, c) = axis.y;
+            deviceRotation(2, c) = axis.z;
+        }
+        
+        Matx33d rotation = imuToCamera * deviceRotation * imuToCamera.t();
+        const Mat& rectifyRotation = calibration->rectifyRotations[stereoLeftCamera];
+        if (!rectifyRotation.empty()) {
+            Matx33d R1(rectifyRotation);
+            rotation = R1 * rotation * R1.t();
+        }
+        
+        homography = K * rotation * K.inv();
+        return true;
     }
     
-    void calculateReprojectionResiduals(const vector<double>& params, vector<double>& residuals) {
+    /**
+     * Rango completo de SGBM en la escala de procesamiento (misma profundidad mínima)
+     */
+    int maxDisparities() const {
+        return max(16, kMaxDisparities >> processingLevel);
+    }
+    
+    /**
+     * Límite de un rango acotado: más allá del rango completo para no recortar objetos cercanos
+     */
+    int disparitySearchLimit() const {
+        return max(16, kDisparitySearchLimit >> processingLevel);
+    }
+    
+    /**
+     * Rango de disparidad del frame actual a partir de las teselas del anterior: cada celda
+     * de la imagen nueva se lleva al frame anterior con la homografía inversa y hereda el rango
+     * de su tesela. Si falta cobertura (zona recién visible) no hay predicción
+     */
+    bool predictDisparityRange(int& minDisparity, int& numDisparities) const {
+        const CameraFrameSlot& slot = frameSlots[stereoLeftCamera];
+        const TemporalReference& reference = disparityReference;
+        if (reference.data.empty() || !reference.poseValid || !slot.poseValid || disparityRangeClipped ||
+            reference.calibrationVersion != calibration->version) {
+            return false;
+        }
+        
+        Matx33d homography;
+        if (!predictRotationHomography(reference.pose, slot.pose, homography)) return false;
+        Matx33d inverse = homography.inv();
+        
+        Size size = rectifiedTiles[stereoLeftCamera]->size();
+        float lowest = FLT_MAX, highest = -FLT_MAX;
+        int covered = 0;
+        
+        for (int ty = 0; ty < kDisparityTileGrid; ty++) {
+            for (int tx = 0; tx < kDisparityTileGrid; tx++) {
+                Vec3d center((tx + 0.5) * size.width / kDisparityTileGrid,
+                             (ty + 0.5) * size.height / kDisparityTileGrid, 1.0);
+                Vec3d previous = inverse * center;
+                if (previous[2] <= 0) continue;
+                
+                double px = previous[0] / previous[2], py = previous[1] / previous[2];
+                if (px < 0 || py < 0 || px >= size.width || py >= size.height) continue;
+                
+                const Vec2f& range = reference.data.at<Vec2f>(int(py * kDisparityTileGrid / size.height),
+                                                              int(px * kDisparityTileGrid / size.width));
+                if (range[0] < 0) continue; // Tesela sin disparidad válida
+                
+                lowest = min(lowest, range[0]);
+                highest = max(highest, range[1]);
+                covered++;
+            }
+        }
+        
+        if (covered < kDisparityTileGrid * kDisparityTileGrid * 3 / 4) return false;
+        
+        int low = max(0, int(floor(lowest)) - kDisparityMargin);
+        int span = int(ceil(highest)) + kDisparityMargin - low;
+        int limit = disparitySearchLimit();
+        span = min(limit, ((span + 15) / 16) * 16);
+        if (span >= limit) return false; // Saturado: probablemente recortado, se reestima
+        
+        minDisparity = min(low, limit - span);
+        numDisparities = span;
+        return true;
+    }
+    
+    /**
+     * Rango [mín, máx] de disparidad válida por tesela del frame actual, con su pose, y si el
+     * mapa toca los extremos del rango buscado (objetos recortados: el rango no es fiable)
+     */
+    void storeDisparityReference(int minDisparity, int numDisparities) {
+        Mat ranges(kDisparityTileGrid, kDisparityTileGrid, CV_32FC2, Scalar(FLT_MAX, -FLT_MAX));
+        
+        // SGBM marca los píxeles inválidos con (minDisparity - 1) * 16. Con minDisparity = 0 el
+        // extremo inferior es el infinito y no recorta nada
+        short invalid = short((minDisparity - 1) * 16);
+        int lowEdge = minDisparity > 0 ? minDisparity * 16 + 8 : INT_MIN;
+        int highEdge = (minDisparity + numDisparities - 1) * 16 - 8;
+        int valid = 0, atEdges = 0;
+        for (int y = 0; y < disparityMap.rows; y++) {
+            const short* row = disparityMap.ptr<short>(y);
+            Vec2f* tileRow = ranges.ptr<Vec2f>(y * kDisparityTileGrid / disparityMap.rows);
+            for (int x = 0; x < disparityMap.cols; x++) {
+                if (row[x] <= invalid) continue;
+                valid++;
+                if (row[x] <= lowEdge || row[x] >= highEdge) atEdges++;
+                Vec2f& range = tileRow[x * kDisparityTileGrid / disparityMap.cols];
+                float value = row[x] / 16.0f;
+                range[0] = min(range[0], value);
+                range[1] = max(range[1], value);
+            }
+        }
+        
+        for (int ty = 0; ty < kDisparityTileGrid; ty++) {
+            for (int tx = 0; tx < kDisparityTileGrid; tx++) {
+                Vec2f& range = ranges.at<Vec2f>(ty, tx);
+                if (range[0] > range[1]) range = Vec2f(-1, -1);
+            }
+        }
+        
+        const CameraFrameSlot& slot = frameSlots[stereoLeftCamera];
+        disparityReference.data = ranges;
+        disparityReference.pose = slot.pose;
+        disparityReference.poseValid = slot.poseValid;
+        disparityReference.calibrationVersion = calibration->version;
+        
+        disparityRangeClipped = atEdges * 100 > valid * kDisparityEdgePercent;
+        if (disparityRangeClipped) {
+            cout << "⚠️ " << atEdges << " de " << valid << " disparidades en los extremos de [" << minDisparity
+                 << ", " << minDisparity + numDisparities << "): se reestimará el rango" << endl;
+        }
+    }
+    
+    /**
+     * Nitidez barata: varianza del Laplaciano sobre la luma reducida a ~320 px de ancho
+     */
+    double measureSharpness(const Mat& frame) const {
+        double scale = min(1.0, 320.0 / frame.cols);
+        Mat small, gray, laplacian;
+        resize(frame, small, Size(), scale, scale, INTER_AREA);
+        cvtColor(small, gray, COLOR_BGR2GRAY);
+        Laplacian(gray, laplacian, CV_16S);
+        
+        Scalar mean, stddev;
+        meanStdDev(laplacian, mean, stddev);
+        return stddev[0] * stddev[0];
+    }
+    
+    /**
+     * Un conjunto está movido si algún frame cae bajo la nitidez mínima o si el giroscopio
+     * indica un giro más rápido que el umbral en el instante de captura
+     */
+    bool isMotionBlurred() const {
+        for (const auto& slot : ingestSlots) {
+            if (!slot.valid) continue;
+            if (sharpnessGate.minSharpness > 0 && slot.sharpness < sharpnessGate.minSharpness) return true;
+            if (sharpnessGate.maxAngularRate > 0 && slot.poseValid &&
+                slot.pose.angularVelocity.norm() > sharpnessGate.maxAngularRate) return true;
+        }
+        return false;
+    }
+    
+    /**
+     * Rectificación directa a gris (remap en punto fijo + luma + ganancia de exposición), diferida:
+     * aquí solo se registra el frame y cada etapa remapea las teselas que consume
+     */
+    void rectifyFrame(int camIdx) {
+        rectifiedTiles[camIdx]->beginFrame(frameSlots[camIdx].frame,
+                                           calibration->rectifyMaps1[processingLevel][camIdx],
+                                           calibration->rectifyMaps2[processingLevel][camIdx],
+                                           photometricGains[camIdx], stereoClaheEnabled);
+    }
+    
+    void calculateReprojectionResiduals(const vector<vector<vector<Point2f>>>& views,
+                                        const vector<double>& params, vector<double>& residuals) {
         // Implementar cálculo de residuales de reproyección para Bundle Adjustment
         residuals.clear();
         
@@ -556,14 +2205,16 @@ private:
         // Es el núcleo del algoritmo de Bundle Adjustment
         
         for (int cam = 0; cam < cameraCount; cam++) {
-            for (size_t pointIdx = 0; pointIdx < imagePointsPerCamera[cam].size(); pointIdx++) {
-                // Calcular punto reproyectado usando parámetros actuales
-                Point2f observed = imagePointsPerCamera[cam][pointIdx];
-                Point2f reprojected = calculateReprojectedPoint(cam, pointIdx, params);
-                
-                // Agregar residuales x e y
-                residuals.push_back(observed.x - reprojected.x);
-                residuals.push_back(observed.y - reprojected.y);
+            int pointIdx = 0;
+            for (const auto& view : views[cam]) {
+                for (const Point2f& observed : view) {
+                    // Calcular punto reproyectado usando parámetros actuales
+                    Point2f reprojected = calculateReprojectedPoint(cam, pointIdx++, params);
+                    
+                    // Agregar residuales x e y
+                    residuals.push_back(observed.x - reprojected.x);
+                    residuals.push_back(observed.y - reprojected.y);
+                }
             }
         }
     }
@@ -573,12 +2224,19 @@ private:
         return Point2f(0, 0); // Placeholder - implementación completa requiere más contexto
     }
     
+    /**
+     * Marca de inválido del último SGBM: con un rango estimado (minDisparity > 0) es positiva
+     */
+    short invalidDisparity() const {
+        return short((disparityMinimum - 1) * 16);
+    }
+    
     void validateDisparityMap() {
         if (disparityMap.empty()) return;
         
         // Análisis de calidad del mapa de disparidad
         Mat validPixels;
-        compare(disparityMap, 0, validPixels, CMP_GT);
+        compare(disparityMap, invalidDisparity(), validPixels, CMP_GT);
         
         int validCount = countNonZero(validPixels);
         double validRatio = double(validCount) / (disparityMap.rows * disparityMap.cols);
@@ -590,23 +2248,23 @@ private:
     
     void validateTriangulation(const vector<Point3f>& points3D, 
                               const vector<Point2f>& points1, 
-                              const vector<Point2f>& points2) {
+                              const vector<Point2f>& points2,
+                              const Mat& P1, const Mat& P2) {
         cout << "🔍 Validando calidad de triangulación..." << endl;
         
-        // Calcular error de reproyección
-        vector<Point2f> reprojected1, reprojected2;
-        
-        Mat rvec1 = Mat::zeros(3, 1, CV_64F);
-        Mat tvec1 = Mat::zeros(3, 1, CV_64F);
-        
-        projectPoints(points3D, rvec1, tvec1, cameraMatrices[0], distortionCoefficients[0], reprojected1);
-        projectPoints(points3D, Mat(rotationMatrices[1]), translationVectors[1], 
-                     cameraMatrices[1], distortionCoefficients[1], reprojected2);
+        // Error de reproyección con las mismas matrices de proyección de la triangulación
+        Matx34d projection1(P1), projection2(P2);
+        auto project = [](const Matx34d& P, const Point3f& point) {
+            Vec3d x = P * Vec4d(point.x, point.y, point.z, 1.0);
+            return Point2f(float(x[0] / x[2]), float(x[1] / x[2]));
+        };
         
         double totalError = 0;
+        triangulationErrors.resize(points1.size());
         for (size_t i = 0; i < points1.size(); i++) {
-            double error1 = norm(points1[i] - reprojected1[i]);
-            double error2 = norm(points2[i] - reprojected2[i]);
+            double error1 = norm(points1[i] - project(projection1, points3D[i]));
+            double error2 = norm(points2[i] - project(projection2, points3D[i]));
+            triangulationErrors[i] = float(0.5 * (error1 + error2));
             totalError += error1 + error2;
         }
         
@@ -622,44 +2280,155 @@ private:
         }
     }
     
+    /**
+     * Recorre los píxeles con Z válida (sin el centinela de reprojectImageTo3D) y los
+     * reconstruye con el modelo pinhole de Q. Confianza = d / (d + 1 px): precisión relativa
+     * de la profundidad para un error de disparidad de un píxel
+     */
+    template <typename Visitor>
+    static void forEachDepthPoint(const Mat& depthZ, const Mat& colorImage, const Matx44d& Q, Visitor&& visit) {
+        const double focal = Q(2, 3);
+        const double principalX = -Q(0, 3), principalY = -Q(1, 3);
+        const Vec3b noColor;
+        
+        for (int y = 0; y < depthZ.rows; y++) {
+            const float* depthRow = depthZ.ptr<float>(y);
+            const Vec3b* colorRow = colorImage.empty() ? nullptr : colorImage.ptr<Vec3b>(y);
+            double rayY = (y - principalY) / focal;
+            
+            for (int x = 0; x < depthZ.cols; x++) {
+                float z = depthRow[x];
+                if (!(z > 0.0f && z < 10000.0f)) continue;
+                
+                double disparity = (focal / z - Q(3, 3)) / Q(3, 2);
+                float confidence = float(max(disparity, 0.0) / (max(disparity, 0.0) + 1.0));
+                Point3f point(float((x - principalX) / focal * z), float(rayY * z), z);
+                visit(point, colorRow ? colorRow[x] : noColor, confidence);
+            }
+        }
+    }
+    
+    /**
+     * Centroide (posición, color y confianza medios) de cada vóxel ocupado. La memoria crece
+     * con los vóxeles ocupados, no con los píxeles
+     */
+    static void writeVoxelizedCloud(PlyStreamWriter& writer, const Mat& depthZ, const Mat& colorImage,
+                                    const Matx44d& Q, float voxelSize) {
+        struct VoxelAccumulator {
+            Point3f sum;
+            Vec3f colorSum;
+            float confidenceSum = 0.0f;
+            int count = 0;
+        };
+        
+        // Índices de vóxel de 21 bits por eje empaquetados en una clave de 64 bits
+        constexpr int64_t kAxisBias = int64_t(1) << 20;
+        const float inverseSize = 1.0f / max(voxelSize, 1e-3f);
+        unordered_map<uint64_t, VoxelAccumulator> voxels;
+        
+        forEachDepthPoint(depthZ, colorImage, Q, [&](const Point3f& point, const Vec3b& color, float confidence) {
+            int64_t vx = int64_t(floor(point.x * inverseSize)) + kAxisBias;
+            int64_t vy = int64_t(floor(point.y * inverseSize)) + kAxisBias;
+            int64_t vz = int64_t(floor(point.z * inverseSize)) + kAxisBias;
+            if (vx < 0 || vy < 0 || vz < 0 || vx >= 2 * kAxisBias || vy >= 2 * kAxisBias || vz >= 2 * kAxisBias) return;
+            
+            VoxelAccumulator& voxel = voxels[uint64_t(vx) << 42 | uint64_t(vy) << 21 | uint64_t(vz)];
+            voxel.sum += point;
+            voxel.colorSum += Vec3f(color[0], color[1], color[2]);
+            voxel.confidenceSum += confidence;
+            voxel.count++;
+        });
+        
+        for (const auto& entry : voxels) {
+            const VoxelAccumulator& voxel = entry.second;
+            float inverseCount = 1.0f / voxel.count;
+            Vec3f color = voxel.colorSum * inverseCount;
+            writer.add(voxel.sum * inverseCount, Vec3b(saturate_cast<uchar>(color[0]), saturate_cast<uchar>(color[1]),
+                                                       saturate_cast<uchar>(color[2])),
+                       voxel.confidenceSum * inverseCount);
+        }
+    }
+    
     void storeMatchesForTriangulation(const vector<KeyPoint>& kp1, 
                                      const vector<KeyPoint>& kp2, 
                                      const vector<DMatch>& matches) {
-        // Almacenar correspondencias para uso en triangulación
-        // Esta función prepara los datos para el procesamiento 3D
+        // Almacenar correspondencias como pares de puntos para la etapa de triangulación
+        matchedPointsLeft.clear();
+        matchedPointsRight.clear();
+        matchedPointsLeft.reserve(matches.size());
+        matchedPointsRight.reserve(matches.size());
+        
+        for (const auto& match : matches) {
+            matchedPointsLeft.push_back(kp1[match.queryIdx].pt);
+            matchedPointsRight.push_back(kp2[match.trainIdx].pt);
+        }
     }
     
     void getCorrespondingPoints(vector<Point2f>& points1, vector<Point2f>& points2) {
-        // Extraer puntos correspondientes de las detecciones almacenadas
-        // Implementación específica depende de cómo se almacenan las correspondencias
+        points1 = refinedPointsLeft;
+        points2 = refinedPointsRight;
     }
     
     void store3DPoints(const vector<Point3f>& points3D) {
         // Almacenar puntos 3D para cálculo de mediciones finales
+        triangulatedPoints = points3D;
         cout << "💾 Almacenando " << points3D.size() << " puntos 3D para mediciones" << endl;
     }
 };
 
 // Funciones C para exposición JNI/bridge
 
+// Registro de instancias: cada handle opaco (jlong) identifica un procesador independiente.
+// Las llamadas copian el shared_ptr bajo el lock del registro y trabajan sin él, de modo que
+// destruir un handle mientras otra llamada lo usa solo libera el procesador al terminar ésta.
+static mutex processorRegistryMutex;
+static unordered_map<jlong, shared_ptr<NativeCameraProcessor>> processorRegistry;
+static jlong nextProcessorHandle = 1;
+
+static shared_ptr<NativeCameraProcessor> lookupProcessor(jlong handle) {
+    lock_guard<mutex> lock(processorRegistryMutex);
+    auto it = processorRegistry.find(handle);
+    return it != processorRegistry.end() ? it->second : nullptr;
+}
+
 extern "C" {
-    static NativeCameraProcessor* processor = nullptr;
-    
-    JNIEXPORT void JNICALL
-    Java_com_cammeasurepro_multicamera_MultiCameraModule_nativeInitializeProcessor(
-        JNIEnv* env, jobject thiz, jint width, jint height, jint cameraCount) {
+    /**
+     * Crea un procesador y devuelve su handle. Si shareWithHandle != 0 la nueva instancia
+     * comparte pool de hilos y caché de calibración con ese procesador
+     * (p.ej. pipeline de preview junto a pipeline de medición de alta precisión)
+     */
+    JNIEXPORT jlong JNICALL
+    Java_com_cammeasurepro_multicamera_MultiCameraModule_nativeCreateProcessor(
+        JNIEnv* env, jobject thiz, jint width, jint height, jint cameraCount, jlong shareWithHandle) {
+        
+        shared_ptr<ThreadPool> sharedPool;
+        shared_ptr<CalibrationCache> sharedCalibration;
+        if (shareWithHandle != 0) {
+            auto source = lookupProcessor(shareWithHandle);
+            if (source == nullptr) {
+                cerr << "❌ Handle de procesador inválido para compartir: " << shareWithHandle << endl;
+                return 0;
+            }
+            sharedPool = source->getThreadPool();
+            sharedCalibration = source->getCalibrationCache();
+        }
         
-        if (processor == nullptr) {
-            processor = new NativeCameraProcessor();
+        auto processor = make_shared<NativeCameraProcessor>(sharedPool, sharedCalibration);
+        if (!processor->initialize(width, height, cameraCount)) {
+            return 0;
         }
         
-        processor->initialize(width, height, cameraCount);
+        lock_guard<mutex> lock(processorRegistryMutex);
+        jlong handle = nextProcessorHandle++;
+        processorRegistry[handle] = processor;
+        return handle;
     }
     
     JNIEXPORT void JNICALL
     Java_com_cammeasurepro_multicamera_MultiCameraModule_nativeProcessMultiFrame(
-        JNIEnv* env, jobject thiz, jobjectArray frameData, jdoubleArray timestamps, jintArray cameraIds) {
+        JNIEnv* env, jobject thiz, jlong handle, jobjectArray frameData, jlongArray timestamps, jintArray cameraIds) {
         
+        auto processor = lookupProcessor(handle);
         if (processor == nullptr) return;
         
         jsize frameCount = env->GetArrayLength(frameData);
@@ -669,7 +2438,7 @@ extern "C" {
         vector<double> timestampsList(frameCount);
         vector<int> cameraIdsList(frameCount);
         
-        jdouble* timestampArray = env->GetDoubleArrayElements(timestamps, nullptr);
+        jlong* timestampArray = env->GetLongArrayElements(timestamps, nullptr);
         jint* cameraIdArray = env->GetIntArrayElements(cameraIds, nullptr);
         
         for (int i = 0; i < frameCount; i++) {
@@ -679,13 +2448,15 @@ extern "C" {
             jbyte* frameBytes = env->GetByteArrayElements(frame, nullptr);
             frameDataList[i].assign(frameBytes, frameBytes + frameSize);
             
-            timestampsList[i] = timestampArray[i];
+            // Timestamps de Camera2 en nanosegundos -> segundos
+            timestampsList[i] = timestampArray[i] / 1e9;
             cameraIdsList[i] = cameraIdArray[i];
             
             env->ReleaseByteArrayElements(frame, frameBytes, JNI_ABORT);
+            env->DeleteLocalRef(frame);
         }
         
-        env->ReleaseDoubleArrayElements(timestamps, timestampArray, JNI_ABORT);
+        env->ReleaseLongArrayElements(timestamps, timestampArray, JNI_ABORT);
         env->ReleaseIntArrayElements(cameraIds, cameraIdArray, JNI_ABORT);
         
         // Procesar frames
@@ -693,10 +2464,330 @@ extern "C" {
     }
     
     JNIEXPORT void JNICALL
-    Java_com_cammeasurepro_multicamera_MultiCameraModule_nativeCleanup(JNIEnv* env, jobject thiz) {
-        if (processor != nullptr) {
-            delete processor;
-            processor = nullptr;
+    Java_com_cammeasurepro_multicamera_MultiCameraModule_nativeSetProcessingMode(
+        JNIEnv* env, jobject thiz, jlong handle, jint mode) {
+        
+        auto processor = lookupProcessor(handle);
+        if (processor == nullptr) return;
+        
+        if (mode < 0 || mode > static_cast<jint>(ProcessingMode::CalibrationCapture)) {
+            cerr << "❌ Modo de procesamiento inválido: " << mode << endl;
+            return;
+        }
+        processor->setProcessingMode(static_cast<ProcessingMode>(mode));
+    }
+    
+    JNIEXPORT void JNICALL
+    Java_com_cammeasurepro_multicamera_MultiCameraModule_nativeSetFeatureMatchMode(
+        JNIEnv* env, jobject thiz, jlong handle, jint mode) {
+        
+        auto processor = lookupProcessor(handle);
+        if (processor == nullptr) return;
+        
+        if (mode < 0 || mode > static_cast<jint>(FeatureMatchMode::DisparityGuided)) {
+            cerr << "❌ Modo de emparejamiento inválido: " << mode << endl;
+            return;
+        }
+        processor->setFeatureMatchMode(static_cast<FeatureMatchMode>(mode));
+    }
+    
+    JNIEXPORT void JNICALL
+    Java_com_cammeasurepro_multicamera_MultiCameraModule_nativeSetCompactDescriptors(
+        JNIEnv* env, jobject thiz, jlong handle, jboolean enabled) {
+        
+        auto processor = lookupProcessor(handle);
+        if (processor == nullptr) return;
+        
+        processor->setCompactDescriptors(enabled == JNI_TRUE);
+    }
+    
+    JNIEXPORT void JNICALL
+    Java_com_cammeasurepro_multicamera_MultiCameraModule_nativeSetSharpnessGate(
+        JNIEnv* env, jobject thiz, jlong handle, jdouble minSharpness, jdouble maxAngularRate) {
+        
+        auto processor = lookupProcessor(handle);
+        if (processor == nullptr) return;
+        
+        processor->setSharpnessGate(minSharpness, maxAngularRate);
+    }
+    
+    /**
+     * Región estéreo (ancho o alto 0 = frame completo)
+     */
+    JNIEXPORT void JNICALL
+    Java_com_cammeasurepro_multicamera_MultiCameraModule_nativeSetStereoRegion(
+        JNIEnv* env, jobject thiz, jlong handle, jint x, jint y, jint width, jint height) {
+        
+        auto processor = lookupProcessor(handle);
+        if (processor == nullptr) return;
+        
+        processor->setStereoRegion(Rect(x, y, width, height));
+    }
+    
+    /**
+     * Estadísticas de profundidad en una región: {media, desviación, incertidumbre 95%, píxeles válidos}
+     */
+    JNIEXPORT jdoubleArray JNICALL
+    Java_com_cammeasurepro_multicamera_MultiCameraModule_nativeQueryDepthStatistics(
+        JNIEnv* env, jobject thiz, jlong handle, jint x, jint y, jint width, jint height) {
+        
+        auto processor = lookupProcessor(handle);
+        if (processor == nullptr) return nullptr;
+        
+        NativeCameraProcessor::DepthStatistics stats = processor->queryDepthStatistics(Rect(x, y, width, height));
+        
+        jdouble values[4] = { stats.meanDepth, stats.stdDepth, stats.uncertainty95, double(stats.validPixels) };
+        jdoubleArray result = env->NewDoubleArray(4);
+        env->SetDoubleArrayRegion(result, 0, 4, values);
+        return result;
+    }
+    
+    /**
+     * Profundidad del frame actual en formato depth_stream (ver DepthStreamCodec.h), o null
+     */
+    JNIEXPORT jbyteArray JNICALL
+    Java_com_cammeasurepro_multicamera_MultiCameraModule_nativeEncodeDepthFrame(
+        JNIEnv* env, jobject thiz, jlong handle, jfloat stepMm) {
+        
+        auto processor = lookupProcessor(handle);
+        if (processor == nullptr) return nullptr;
+        
+        vector<uint8_t> encoded;
+        if (!processor->encodeDepthStream(encoded, stepMm)) return nullptr;
+        
+        jbyteArray result = env->NewByteArray(jsize(encoded.size()));
+        env->SetByteArrayRegion(result, 0, jsize(encoded.size()), reinterpret_cast<const jbyte*>(encoded.data()));
+        return result;
+    }
+    
+    /**
+     * Nube de puntos a PLY binario (fuente 0 triangulada, 1 densa, 2 por vóxeles).
+     * Bloquea hasta terminar: el módulo Java lo llama desde un hilo propio
+     */
+    JNIEXPORT jlong JNICALL
+    Java_com_cammeasurepro_multicamera_MultiCameraModule_nativeExportPointCloud(
+        JNIEnv* env, jobject thiz, jlong handle, jstring path, jint source, jboolean colors,
+        jboolean confidence, jfloat voxelSize) {
+        
+        auto processor = lookupProcessor(handle);
+        if (processor == nullptr) return -1;
+        
+        if (source < 0 || source > static_cast<jint>(NativeCameraProcessor::PointCloudSource::Voxelized)) {
+            cerr << "❌ Fuente de nube de puntos inválida: " << source << endl;
+            return -1;
+        }
+        
+        const char* pathChars = env->GetStringUTFChars(path, nullptr);
+        string pathString(pathChars);
+        env->ReleaseStringUTFChars(path, pathChars);
+        
+        NativeCameraProcessor::PointCloudExportOptions options;
+        options.source = static_cast<NativeCameraProcessor::PointCloudSource>(source);
+        options.colors = colors == JNI_TRUE;
+        options.confidence = confidence == JNI_TRUE;
+        options.voxelSize = voxelSize;
+        return processor->exportPointCloud(pathString, options);
+    }
+    
+    /**
+     * Grabación de los conjuntos de frames de entrada en un anillo de capacityMb
+     */
+    JNIEXPORT jboolean JNICALL
+    Java_com_cammeasurepro_multicamera_MultiCameraModule_nativeStartRecording(
+        JNIEnv* env, jobject thiz, jlong handle, jstring path, jint capacityMb) {
+        
+        auto processor = lookupProcessor(handle);
+        if (processor == nullptr || capacityMb <= 0) return JNI_FALSE;
+        
+        const char* pathChars = env->GetStringUTFChars(path, nullptr);
+        string pathString(pathChars);
+        env->ReleaseStringUTFChars(path, pathChars);
+        
+        return processor->startRecording(pathString, uint64_t(capacityMb) * 1024 * 1024) ? JNI_TRUE : JNI_FALSE;
+    }
+    
+    JNIEXPORT void JNICALL
+    Java_com_cammeasurepro_multicamera_MultiCameraModule_nativeStopRecording(
+        JNIEnv* env, jobject thiz, jlong handle) {
+        
+        auto processor = lookupProcessor(handle);
+        if (processor == nullptr) return;
+        
+        processor->stopRecording();
+    }
+    
+    /**
+     * Reprocesa una grabación; devuelve los conjuntos reproducidos o -1
+     */
+    JNIEXPORT jint JNICALL
+    Java_com_cammeasurepro_multicamera_MultiCameraModule_nativeReplayRecording(
+        JNIEnv* env, jobject thiz, jlong handle, jstring path) {
+        
+        auto processor = lookupProcessor(handle);
+        if (processor == nullptr) return -1;
+        
+        const char* pathChars = env->GetStringUTFChars(path, nullptr);
+        string pathString(pathChars);
+        env->ReleaseStringUTFChars(path, pathChars);
+        
+        return processor->replayRecording(pathString);
+    }
+    
+    /**
+     * Plano dominante (0 = horizontal, 1 = vertical): {nx, ny, nz, offset, inliers, iteraciones}
+     */
+    JNIEXPORT jdoubleArray JNICALL
+    Java_com_cammeasurepro_multicamera_MultiCameraModule_nativeDetectPlane(
+        JNIEnv* env, jobject thiz, jlong handle, jint orientation) {
+        
+        auto processor = lookupProcessor(handle);
+        if (processor == nullptr) return nullptr;
+        
+        PlaneFit plane = processor->queryDominantPlane(
+            orientation == 1 ? PlaneOrientation::Vertical : PlaneOrientation::Horizontal);
+        if (!plane.valid) return nullptr;
+        
+        jdouble values[6] = { plane.normal.x, plane.normal.y, plane.normal.z, plane.offset,
+                              double(plane.inliers), double(plane.iterations) };
+        jdoubleArray result = env->NewDoubleArray(6);
+        env->SetDoubleArrayRegion(result, 0, 6, values);
+        return result;
+    }
+    
+    /**
+     * Normal de la superficie en un píxel del mapa de profundidad: {nx, ny, nz}, o null
+     */
+    JNIEXPORT jdoubleArray JNICALL
+    Java_com_cammeasurepro_multicamera_MultiCameraModule_nativeQuerySurfaceNormal(
+        JNIEnv* env, jobject thiz, jlong handle, jint x, jint y) {
+        
+        auto processor = lookupProcessor(handle);
+        if (processor == nullptr) return nullptr;
+        
+        Vec3f normal;
+        if (!processor->querySurfaceNormal(Point(x, y), normal)) return nullptr;
+        
+        jdouble values[3] = { normal[0], normal[1], normal[2] };
+        jdoubleArray result = env->NewDoubleArray(3);
+        env->SetDoubleArrayRegion(result, 0, 3, values);
+        return result;
+    }
+    
+    /**
+     * Malla de la profundidad: {vértices float32 xyz, triángulos int32} en little-endian, o null
+     */
+    JNIEXPORT jobjectArray JNICALL
+    Java_com_cammeasurepro_multicamera_MultiCameraModule_nativeGenerateMesh(
+        JNIEnv* env, jobject thiz, jlong handle, jint triangleBudget) {
+        
+        auto processor = lookupProcessor(handle);
+        if (processor == nullptr) return nullptr;
+        
+        SurfaceMesh mesh = processor->queryMesh(triangleBudget);
+        if (mesh.triangles.empty()) return nullptr;
+        
+        jsize vertexBytes = jsize(mesh.vertices.size() * sizeof(Point3f));
+        jsize triangleBytes = jsize(mesh.triangles.size() * sizeof(Vec3i));
+        jbyteArray vertices = env->NewByteArray(vertexBytes);
+        env->SetByteArrayRegion(vertices, 0, vertexBytes, reinterpret_cast<const jbyte*>(mesh.vertices.data()));
+        jbyteArray triangles = env->NewByteArray(triangleBytes);
+        env->SetByteArrayRegion(triangles, 0, triangleBytes, reinterpret_cast<const jbyte*>(mesh.triangles.data()));
+        
+        jobjectArray result = env->NewObjectArray(2, env->FindClass("[B"), nullptr);
+        env->SetObjectArrayElement(result, 0, vertices);
+        env->SetObjectArrayElement(result, 1, triangles);
+        return result;
+    }
+    
+    /**
+     * Calibración con las vistas acumuladas: estéreo con 2+ cámaras, corrección de lente con una
+     */
+    JNIEXPORT jboolean JNICALL
+    Java_com_cammeasurepro_multicamera_MultiCameraModule_nativeRunCalibration(
+        JNIEnv* env, jobject thiz, jlong handle) {
+        
+        auto processor = lookupProcessor(handle);
+        if (processor == nullptr) return JNI_FALSE;
+        
+        // Una excepción de OpenCV no puede cruzar la frontera JNI: la calibración falla sin más
+        try {
+            return processor->performAutomaticCalibration() ? JNI_TRUE : JNI_FALSE;
+        } catch (const cv::Exception& e) {
+            cerr << "❌ Error de OpenCV en la calibración: " << e.what() << endl;
+            return JNI_FALSE;
+        }
+    }
+    
+    /**
+     * Plano de referencia explícito, o con cameraHeight > 0 el suelo según la gravedad de la IMU
+     */
+    JNIEXPORT jboolean JNICALL
+    Java_com_cammeasurepro_multicamera_MultiCameraModule_nativeSetReferencePlane(
+        JNIEnv* env, jobject thiz, jlong handle, jdouble normalX, jdouble normalY, jdouble normalZ,
+        jdouble offset, jdouble cameraHeight) {
+        
+        auto processor = lookupProcessor(handle);
+        if (processor == nullptr) return JNI_FALSE;
+        
+        if (cameraHeight > 0) {
+            return processor->setReferencePlaneFromGravity(cameraHeight) ? JNI_TRUE : JNI_FALSE;
+        }
+        processor->setReferencePlane(Vector3(normalX, normalY, normalZ), offset);
+        return JNI_TRUE;
+    }
+    
+    /**
+     * Píxeles {x0, y0, x1, y1, ...} -> {X, Y, Z (mm) sobre el plano de referencia, píxel
+     * usado x, y, 1 si se refinó a subpíxel} por punto
+     */
+    JNIEXPORT jdoubleArray JNICALL
+    Java_com_cammeasurepro_multicamera_MultiCameraModule_nativeMeasureOnReferencePlane(
+        JNIEnv* env, jobject thiz, jlong handle, jfloatArray pixelData) {
+        
+        auto processor = lookupProcessor(handle);
+        if (processor == nullptr || pixelData == nullptr) return nullptr;
+        
+        jsize length = env->GetArrayLength(pixelData) / 2 * 2;
+        vector<jfloat> coordinates(length);
+        env->GetFloatArrayRegion(pixelData, 0, length, coordinates.data());
+        
+        vector<Point2f> pixels;
+        pixels.reserve(length / 2);
+        for (jsize i = 0; i < length; i += 2) {
+            pixels.emplace_back(coordinates[i], coordinates[i + 1]);
+        }
+        
+        vector<Point3d> points;
+        vector<char> refined;
+        if (!processor->measureOnReferencePlane(pixels, points, refined)) return nullptr;
+        
+        vector<jdouble> values;
+        values.reserve(points.size() * 6);
+        for (size_t i = 0; i < points.size(); i++) {
+            values.push_back(points[i].x);
+            values.push_back(points[i].y);
+            values.push_back(points[i].z);
+            values.push_back(pixels[i].x);
+            values.push_back(pixels[i].y);
+            values.push_back(refined[i] ? 1.0 : 0.0);
+        }
+        jdoubleArray result = env->NewDoubleArray(jsize(values.size()));
+        env->SetDoubleArrayRegion(result, 0, jsize(values.size()), values.data());
+        return result;
+    }
+    
+    JNIEXPORT void JNICALL
+    Java_com_cammeasurepro_multicamera_MultiCameraModule_nativeDestroyProcessor(
+        JNIEnv* env, jobject thiz, jlong handle) {
+        
+        shared_ptr<NativeCameraProcessor> released;
+        {
+            lock_guard<mutex> lock(processorRegistryMutex);
+            auto it = processorRegistry.find(handle);
+            if (it == processorRegistry.end()) return;
+            released = std::move(it->second);
+            processorRegistry.erase(it);
         }
+        // La destrucción (y el cierre del pool si no es compartido) ocurre fuera del lock
     }
 }
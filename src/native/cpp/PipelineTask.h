@@ -0,0 +1,208 @@
+/**
+ * PipelineTask - Corrutinas C++20 para orquestar etapas sobre el ThreadPool
+ * Tareas perezosas con continuación, whenAll sin bloquear hilos y syncWait para el borde JNI
+ */
+
+#pragma once
+
+#include "ThreadPool.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <coroutine>
+#include <exception>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+/**
+ * Tarea sin valor de retorno; arranca al ser esperada (co_await) y al terminar
+ * transfiere el control a quien la esperaba
+ */
+class PipelineTask {
+public:
+    struct promise_type {
+        std::coroutine_handle<> continuation = std::noop_coroutine();
+        std::exception_ptr exception;
+
+        PipelineTask get_return_object() {
+            return PipelineTask(std::coroutine_handle<promise_type>::from_promise(*this));
+        }
+
+        std::suspend_always initial_suspend() noexcept { return {}; }
+
+        struct FinalAwaiter {
+            bool await_ready() noexcept { return false; }
+            std::coroutine_handle<> await_suspend(std::coroutine_handle<promise_type> handle) noexcept {
+                return handle.promise().continuation;
+            }
+            void await_resume() noexcept {}
+        };
+
+        FinalAwaiter final_suspend() noexcept { return {}; }
+        void return_void() {}
+        void unhandled_exception() { exception = std::current_exception(); }
+    };
+
+    PipelineTask() = default;
+
+    PipelineTask(PipelineTask&& other) noexcept : handle(std::exchange(other.handle, nullptr)) {}
+
+    PipelineTask& operator=(PipelineTask&& other) noexcept {
+        if (this != &other) {
+            if (handle) handle.destroy();
+            handle = std::exchange(other.handle, nullptr);
+        }
+        return *this;
+    }
+
+    PipelineTask(const PipelineTask&) = delete;
+    PipelineTask& operator=(const PipelineTask&) = delete;
+
+    ~PipelineTask() {
+        if (handle) handle.destroy();
+    }
+
+    bool await_ready() const noexcept {
+        return !handle || handle.done();
+    }
+
+    std::coroutine_handle<> await_suspend(std::coroutine_handle<> awaiting) noexcept {
+        handle.promise().continuation = awaiting;
+        return handle; // Transferencia simétrica: arranca la tarea
+    }
+
+    void await_resume() {
+        if (handle && handle.promise().exception) {
+            std::rethrow_exception(handle.promise().exception);
+        }
+    }
+
+private:
+    explicit PipelineTask(std::coroutine_handle<promise_type> h) : handle(h) {}
+
+    std::coroutine_handle<promise_type> handle;
+};
+
+namespace pipeline_detail {
+
+// Corrutina autónoma: arranca de inmediato y libera su frame al terminar
+struct DetachedTask {
+    struct promise_type {
+        DetachedTask get_return_object() { return {}; }
+        std::suspend_never initial_suspend() noexcept { return {}; }
+        std::suspend_never final_suspend() noexcept { return {}; }
+        void return_void() {}
+        void unhandled_exception() { std::terminate(); }
+    };
+};
+
+struct JoinState {
+    std::atomic<size_t> remaining{0};
+    std::coroutine_handle<> continuation;
+    std::mutex errorMutex;
+    std::exception_ptr error;
+};
+
+inline DetachedTask runJoined(PipelineTask& task, JoinState& state) {
+    try {
+        co_await task;
+    } catch (...) {
+        std::lock_guard<std::mutex> lock(state.errorMutex);
+        if (!state.error) state.error = std::current_exception();
+    }
+
+    // La última tarea en terminar reanuda a quien espera el grupo
+    if (state.remaining.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+        state.continuation.resume();
+    }
+}
+
+struct WhenAllAwaiter {
+    std::vector<PipelineTask> tasks;
+    JoinState state;
+
+    bool await_ready() const noexcept {
+        return tasks.empty();
+    }
+
+    bool await_suspend(std::coroutine_handle<> awaiting) {
+        state.continuation = awaiting;
+        // +1 propio: evita que una tarea reanude antes de lanzar todas
+        state.remaining.store(tasks.size() + 1, std::memory_order_relaxed);
+
+        for (auto& task : tasks) {
+            runJoined(task, state);
+        }
+
+        // Si todas terminaron ya, se continúa sin suspender
+        return state.remaining.fetch_sub(1, std::memory_order_acq_rel) != 1;
+    }
+
+    void await_resume() {
+        if (state.error) std::rethrow_exception(state.error);
+    }
+};
+
+struct ScheduleAwaiter {
+    ThreadPool& pool;
+
+    bool await_ready() const noexcept { return false; }
+
+    void await_suspend(std::coroutine_handle<> handle) {
+        pool.post([handle] { handle.resume(); });
+    }
+
+    void await_resume() const noexcept {}
+};
+
+struct SyncState {
+    std::mutex mutex;
+    std::condition_variable condition;
+    bool done = false;
+    std::exception_ptr error;
+};
+
+inline DetachedTask runSync(PipelineTask& task, SyncState& state) {
+    std::exception_ptr error;
+    try {
+        co_await task;
+    } catch (...) {
+        error = std::current_exception();
+    }
+
+    // Notificación bajo el lock: el que espera no destruye el estado antes de soltarlo
+    std::lock_guard<std::mutex> lock(state.mutex);
+    state.error = error;
+    state.done = true;
+    state.condition.notify_one();
+}
+
+} // namespace pipeline_detail
+
+/**
+ * co_await scheduleOn(pool): continúa la corrutina en un hilo del pool
+ */
+inline pipeline_detail::ScheduleAwaiter scheduleOn(ThreadPool& pool) {
+    return pipeline_detail::ScheduleAwaiter{ pool };
+}
+
+/**
+ * co_await whenAll(tareas): ejecuta las tareas concurrentemente y reanuda al terminar todas
+ */
+inline pipeline_detail::WhenAllAwaiter whenAll(std::vector<PipelineTask> tasks) {
+    return pipeline_detail::WhenAllAwaiter{ std::move(tasks), {} };
+}
+
+/**
+ * Espera bloqueante de una tarea desde código no corrutina (entrada JNI)
+ */
+inline void syncWait(PipelineTask task) {
+    pipeline_detail::SyncState state;
+    pipeline_detail::runSync(task, state);
+
+    std::unique_lock<std::mutex> lock(state.mutex);
+    state.condition.wait(lock, [&state] { return state.done; });
+
+    if (state.error) std::rethrow_exception(state.error);
+}
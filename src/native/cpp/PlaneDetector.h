@@ -0,0 +1,191 @@
+/**
+ * PlaneDetector - RANSAC de planos restringido por la gravedad de la IMU
+ * Con la dirección vertical conocida, un plano horizontal queda fijado por 1 punto
+ * y uno vertical por 2, en lugar de los 3 puntos de un RANSAC sin priori
+ */
+
+#pragma once
+
+#include "SensorFusionEngine.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+enum class PlaneOrientation : int {
+    Horizontal = 0,     // Suelo, mesa: normal paralela a la gravedad
+    Vertical            // Paredes: normal perpendicular a la gravedad
+};
+
+struct PlaneSearchParams {
+    double inlierThreshold = 10.0;   // Distancia punto-plano máxima (mm)
+    double maxNormalDeviationDeg = 5.0; // Desviación tolerada respecto a la orientación pedida
+    double confidence = 0.99;
+    int maxIterations = 200;
+};
+
+/**
+ * Plano normal·p + offset = 0 con normal unitaria orientada hacia arriba (horizontal)
+ */
+struct PlaneFit {
+    Vector3 normal;
+    double offset = 0.0;
+    int inliers = 0;
+    int iterations = 0;
+    bool valid = false;
+
+    double distance(const Vector3& point) const {
+        return normal.dot(point) + offset;
+    }
+};
+
+class PlaneDetector {
+public:
+    /**
+     * points: nube en el marco de la cámara; up: vertical (opuesta a la gravedad) en el mismo marco
+     */
+    static PlaneFit detect(const std::vector<Vector3>& points, const Vector3& up,
+                           PlaneOrientation orientation, const PlaneSearchParams& params = PlaneSearchParams()) {
+        PlaneFit best;
+        size_t minimalSample = orientation == PlaneOrientation::Horizontal ? 1 : 2;
+        if (points.size() < std::max<size_t>(minimalSample, 3) || up.norm() < 1e-9) return best;
+
+        Vector3 upAxis = up.normalized();
+        uint64_t rngState = 0x2545f4914f6cdd1dULL ^ points.size();
+        int requiredIterations = params.maxIterations;
+
+        for (int iteration = 0; iteration < requiredIterations; iteration++) {
+            Vector3 normal;
+            const Vector3& anchor = points[nextRandom(rngState) % points.size()];
+
+            if (orientation == PlaneOrientation::Horizontal) {
+                // Un punto basta: la normal es la vertical
+                normal = upAxis;
+            } else {
+                // Dos puntos: la normal es perpendicular a la vertical y al segmento entre ellos
+                const Vector3& second = points[nextRandom(rngState) % points.size()];
+                normal = upAxis.cross(second - anchor);
+                if (normal.norm() < 1e-6) continue; // Muestra degenerada (puntos en la misma vertical)
+                normal = normal.normalized();
+            }
+
+            PlaneFit candidate;
+            candidate.normal = normal;
+            candidate.offset = -normal.dot(anchor);
+            candidate.inliers = countInliers(points, candidate, params.inlierThreshold);
+
+            if (candidate.inliers > best.inliers) {
+                best = candidate;
+
+                // Iteraciones adaptativas: N = log(1 - p) / log(1 - w^s)
+                double inlierRatio = double(best.inliers) / points.size();
+                double sampleSuccess = std::pow(inlierRatio, double(minimalSample));
+                if (sampleSuccess >= 1.0) {
+                    requiredIterations = iteration + 1;
+                } else if (sampleSuccess > 0.0) {
+                    double needed = std::log(1.0 - params.confidence) / std::log(1.0 - sampleSuccess);
+                    requiredIterations = std::min(params.maxIterations, int(std::ceil(needed)));
+                }
+            }
+            best.iterations = iteration + 1;
+        }
+
+        if (best.inliers < 3) return PlaneFit();
+
+        refine(points, upAxis, orientation, params, best);
+        best.valid = true;
+        return best;
+    }
+
+private:
+    static uint64_t nextRandom(uint64_t& state) {
+        // xorshift64*: reproducible y sin estado global
+        state ^= state >> 12;
+        state ^= state << 25;
+        state ^= state >> 27;
+        return state * 0x2545f4914f6cdd1dULL;
+    }
+
+    static int countInliers(const std::vector<Vector3>& points, const PlaneFit& plane, double threshold) {
+        int count = 0;
+        for (const auto& point : points) {
+            if (std::fabs(plane.distance(point)) <= threshold) count++;
+        }
+        return count;
+    }
+
+    /**
+     * Mínimos cuadrados sobre los inliers con inclinación linealizada de la normal
+     * (n = n0 + a·t1 + b·t2), limitada a la desviación tolerada
+     */
+    static void refine(const std::vector<Vector3>& points, const Vector3& upAxis,
+                       PlaneOrientation orientation, const PlaneSearchParams& params, PlaneFit& plane) {
+        Vector3 n0 = plane.normal;
+        Vector3 t1 = orientation == PlaneOrientation::Horizontal ? anyPerpendicular(n0) : upAxis;
+        Vector3 t2 = n0.cross(t1).normalized();
+
+        // Ecuaciones normales de (t1·p) a + (t2·p) b + c = -(n0·p)
+        double A[3][3] = {};
+        double rhs[3] = {};
+        for (const auto& point : points) {
+            if (std::fabs(plane.distance(point)) > params.inlierThreshold) continue;
+            double row[3] = { t1.dot(point), t2.dot(point), 1.0 };
+            double target = -n0.dot(point);
+            for (int r = 0; r < 3; r++) {
+                for (int c = 0; c < 3; c++) A[r][c] += row[r] * row[c];
+                rhs[r] += row[r] * target;
+            }
+        }
+
+        double solution[3];
+        if (!solve3x3(A, rhs, solution)) return;
+
+        double maxTilt = std::tan(params.maxNormalDeviationDeg * M_PI / 180.0);
+        double a = solution[0], b = solution[1];
+        double tilt = std::sqrt(a * a + b * b);
+        if (tilt > maxTilt) {
+            a *= maxTilt / tilt;
+            b *= maxTilt / tilt;
+        }
+
+        Vector3 normal = n0 + t1 * a + t2 * b;
+        double scale = 1.0 / normal.norm();
+        plane.normal = normal * scale;
+
+        // Offset como media de los inliers sobre la normal refinada
+        double offsetSum = 0.0;
+        int count = 0;
+        for (const auto& point : points) {
+            if (std::fabs(plane.distance(point)) > params.inlierThreshold) continue;
+            offsetSum += -plane.normal.dot(point);
+            count++;
+        }
+        if (count > 0) plane.offset = offsetSum / count;
+        plane.inliers = countInliers(points, plane, params.inlierThreshold);
+    }
+
+    static Vector3 anyPerpendicular(const Vector3& v) {
+        Vector3 axis = std::fabs(v.x) < 0.9 ? Vector3(1, 0, 0) : Vector3(0, 1, 0);
+        return v.cross(axis).normalized();
+    }
+
+    static bool solve3x3(const double A[3][3], const double b[3], double x[3]) {
+        double det = A[0][0] * (A[1][1] * A[2][2] - A[1][2] * A[2][1])
+                   - A[0][1] * (A[1][0] * A[2][2] - A[1][2] * A[2][0])
+                   + A[0][2] * (A[1][0] * A[2][1] - A[1][1] * A[2][0]);
+        if (std::fabs(det) < 1e-12) return false;
+
+        // Regla de Cramer
+        for (int col = 0; col < 3; col++) {
+            double M[3][3];
+            for (int r = 0; r < 3; r++) {
+                for (int c = 0; c < 3; c++) M[r][c] = (c == col) ? b[r] : A[r][c];
+            }
+            x[col] = (M[0][0] * (M[1][1] * M[2][2] - M[1][2] * M[2][1])
+                    - M[0][1] * (M[1][0] * M[2][2] - M[1][2] * M[2][0])
+                    + M[0][2] * (M[1][0] * M[2][1] - M[1][1] * M[2][0])) / det;
+        }
+        return true;
+    }
+};
@@ -0,0 +1,113 @@
+/**
+ * PlyStreamWriter - Escritura de nubes de puntos en PLY binario por bloques
+ * Los puntos pasan por un buffer de tamaño fijo que se vuelca al fichero al llenarse,
+ * así una nube grande nunca existe entera en memoria. El número de vértices se deja
+ * en un campo de ancho fijo de la cabecera y se completa al cerrar
+ *
+ * Vértice (binary_little_endian, nativo en ARM/x86):
+ *   float x, y, z [+ uchar red, green, blue] [+ float confidence]
+ */
+
+#pragma once
+
+#include <opencv2/core.hpp>
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+
+class PlyStreamWriter {
+public:
+    static constexpr size_t kChunkPoints = 16384;
+
+    PlyStreamWriter() = default;
+    ~PlyStreamWriter() {
+        if (file != nullptr) std::fclose(file);
+    }
+
+    PlyStreamWriter(const PlyStreamWriter&) = delete;
+    PlyStreamWriter& operator=(const PlyStreamWriter&) = delete;
+
+    /**
+     * Crea el fichero y escribe la cabecera con el recuento pendiente
+     */
+    bool open(const std::string& path, bool withColors, bool withConfidence) {
+        file = std::fopen(path.c_str(), "wb");
+        if (file == nullptr) return false;
+
+        colors = withColors;
+        confidence = withConfidence;
+        stride = 3 * sizeof(float) + (colors ? 3 : 0) + (confidence ? sizeof(float) : 0);
+        buffer.resize(kChunkPoints * stride);
+        buffered = 0;
+        written = 0;
+
+        std::string header = "ply\nformat binary_little_endian 1.0\ncomment CamMeasurePro\n";
+        std::fputs(header.c_str(), file);
+        countOffset = long(header.size()) + long(std::strlen("element vertex "));
+        std::fprintf(file, "element vertex %-20s\n", "0");
+        std::fputs("property float x\nproperty float y\nproperty float z\n", file);
+        if (colors) std::fputs("property uchar red\nproperty uchar green\nproperty uchar blue\n", file);
+        if (confidence) std::fputs("property float confidence\n", file);
+        std::fputs("end_header\n", file);
+        return !std::ferror(file);
+    }
+
+    /**
+     * Añade un punto (color en BGR como los frames de OpenCV)
+     */
+    void add(const cv::Point3f& point, const cv::Vec3b& bgr = cv::Vec3b(), float pointConfidence = 1.0f) {
+        uint8_t* cursor = buffer.data() + buffered * stride;
+        std::memcpy(cursor, &point, 3 * sizeof(float));
+        cursor += 3 * sizeof(float);
+        if (colors) {
+            cursor[0] = bgr[2];
+            cursor[1] = bgr[1];
+            cursor[2] = bgr[0];
+            cursor += 3;
+        }
+        if (confidence) std::memcpy(cursor, &pointConfidence, sizeof(float));
+
+        if (++buffered == kChunkPoints) flush();
+    }
+
+    /**
+     * Vuelca el último bloque, completa el recuento de la cabecera y cierra.
+     * Devuelve false si alguna escritura falló
+     */
+    bool finish() {
+        if (file == nullptr) return false;
+
+        flush();
+        bool ok = !std::ferror(file) && std::fseek(file, countOffset, SEEK_SET) == 0;
+        if (ok) {
+            std::fprintf(file, "%-20llu", static_cast<unsigned long long>(written));
+        }
+        ok = std::fclose(file) == 0 && ok;
+        file = nullptr;
+        return ok;
+    }
+
+    uint64_t count() const {
+        return written + buffered;
+    }
+
+private:
+    void flush() {
+        if (buffered == 0) return;
+        std::fwrite(buffer.data(), stride, buffered, file);
+        written += buffered;
+        buffered = 0;
+    }
+
+    std::FILE* file = nullptr;
+    bool colors = false;
+    bool confidence = false;
+    size_t stride = 0;
+    std::vector<uint8_t> buffer;
+    size_t buffered = 0;
+    uint64_t written = 0;
+    long countOffset = 0;
+};
@@ -0,0 +1,232 @@
+/**
+ * RectifiedTileCache - Rectificación perezosa por teselas de una cámara
+ * Cada frame solo registra su fuente; las etapas piden regiones y se remapean
+ * únicamente las teselas que tocan (una vez por frame)
+ *
+ * CLAHE opcional con la rejilla alineada a las teselas (una LUT por tesela de 128 px, en
+ * lugar de la rejilla 8x8 sobre la imagen completa): una región solo necesita sus teselas
+ * más un halo de una para interpolar entre LUTs vecinas, así que sigue siendo perezoso
+ */
+
+#pragma once
+
+#include "RectifyKernels.h"
+#include "StereoPreprocess.h"
+
+#include <opencv2/core.hpp>
+#include <opencv2/imgproc.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+class RectifiedTileCache {
+public:
+    static constexpr int kTileSize = 128;
+    static constexpr double kClaheClipLimit = 2.0;
+
+    /**
+     * Nuevo frame: guarda fuente, mapas y ganancia sin remapear nada.
+     * Sin mapas (cámara sin calibrar) las teselas se convierten a gris sin remap
+     */
+    void beginFrame(const cv::Mat& frame, const cv::Mat& map1, const cv::Mat& map2,
+                    const PhotometricGain& photometric, bool clahe) {
+        std::lock_guard<std::mutex> lock(mutex);
+        source = frame;
+        rectifyMap1 = map1;
+        rectifyMap2 = map2;
+        gain = photometric;
+        claheEnabled = clahe;
+
+        cv::Size size = rectifyMap1.empty() ? source.size() : rectifyMap1.size();
+        if (gray.size() != size) {
+            gray.create(size, CV_8UC1);
+        }
+        if (claheEnabled && equalized.size() != size) {
+            equalized.create(size, CV_8UC1);
+        }
+
+        tilesX = (size.width + kTileSize - 1) / kTileSize;
+        tilesY = (size.height + kTileSize - 1) / kTileSize;
+        size_t tiles = size_t(tilesX) * tilesY;
+        tileReady.assign(tiles, 0);
+        lutReady.assign(tiles, 0);
+        equalizedReady.assign(tiles, 0);
+        luts.resize(tiles * 256);
+        tilesRectified = 0;
+    }
+
+    /**
+     * Garantiza rectificada (y con CLAHE, ecualizada) la región (vacía = imagen completa) y
+     * devuelve la imagen entera; fuera de las regiones pedidas en este frame su contenido no
+     * está definido
+     */
+    const cv::Mat& acquire(cv::Rect region = cv::Rect()) {
+        std::lock_guard<std::mutex> lock(mutex);
+        cv::Mat& output = claheEnabled ? equalized : gray;
+
+        cv::Rect bounds(0, 0, gray.cols, gray.rows);
+        if (region.area() == 0) {
+            region = bounds;
+        }
+        region &= bounds;
+        if (region.area() == 0) return output;
+
+        int firstX = region.x / kTileSize, lastX = (region.x + region.width - 1) / kTileSize;
+        int firstY = region.y / kTileSize, lastY = (region.y + region.height - 1) / kTileSize;
+        if (!claheEnabled) {
+            rectifyTiles(firstX, lastX, firstY, lastY);
+            return output;
+        }
+
+        // Cada píxel interpola las LUTs de las 4 teselas más cercanas: halo de una tesela
+        int haloX0 = std::max(firstX - 1, 0), haloX1 = std::min(lastX + 1, tilesX - 1);
+        int haloY0 = std::max(firstY - 1, 0), haloY1 = std::min(lastY + 1, tilesY - 1);
+        rectifyTiles(haloX0, haloX1, haloY0, haloY1);
+        for (int ty = haloY0; ty <= haloY1; ty++) {
+            for (int tx = haloX0; tx <= haloX1; tx++) {
+                size_t index = size_t(ty) * tilesX + tx;
+                if (lutReady[index]) continue;
+                buildTileLut(tx, ty);
+                lutReady[index] = 1;
+            }
+        }
+        for (int ty = firstY; ty <= lastY; ty++) {
+            for (int tx = firstX; tx <= lastX; tx++) {
+                size_t index = size_t(ty) * tilesX + tx;
+                if (equalizedReady[index]) continue;
+                equalizeTile(tx, ty);
+                equalizedReady[index] = 1;
+            }
+        }
+        return output;
+    }
+
+    cv::Size size() const {
+        std::lock_guard<std::mutex> lock(mutex);
+        return gray.size();
+    }
+
+    /**
+     * Teselas remapeadas en el frame actual frente al total
+     */
+    int rectifiedTileCount() const {
+        std::lock_guard<std::mutex> lock(mutex);
+        return tilesRectified;
+    }
+
+    int tileCount() const {
+        std::lock_guard<std::mutex> lock(mutex);
+        return tilesX * tilesY;
+    }
+
+private:
+    cv::Rect tileRect(int tx, int ty) const {
+        return cv::Rect(tx * kTileSize, ty * kTileSize, kTileSize, kTileSize) & cv::Rect(0, 0, gray.cols, gray.rows);
+    }
+
+    void rectifyTiles(int firstX, int lastX, int firstY, int lastY) {
+        for (int ty = firstY; ty <= lastY; ty++) {
+            for (int tx = firstX; tx <= lastX; tx++) {
+                char& ready = tileReady[size_t(ty) * tilesX + tx];
+                if (ready) continue;
+
+                cv::Rect tile = tileRect(tx, ty);
+                if (rectifyMap1.empty()) {
+                    convertToNormalizedGray(source, gray, gain, tile);
+                } else {
+                    remapToGray(source, rectifyMap1, rectifyMap2, gray, gain, tile);
+                }
+                ready = 1;
+                tilesRectified++;
+            }
+        }
+    }
+
+    /**
+     * LUT de la tesela como la de cv::CLAHE: histograma recortado a clip·área/256, exceso
+     * repartido por igual (el resto, a intervalos) y CDF escalada a 0..255
+     */
+    void buildTileLut(int tx, int ty) {
+        cv::Rect tile = tileRect(tx, ty);
+        int histogram[256] = {};
+        for (int y = tile.y; y < tile.y + tile.height; y++) {
+            const uint8_t* row = gray.ptr<uint8_t>(y);
+            for (int x = tile.x; x < tile.x + tile.width; x++) histogram[row[x]]++;
+        }
+
+        const int area = tile.area();
+        int clipLimit = std::max(1, int(kClaheClipLimit * area / 256));
+        int clipped = 0;
+        for (int& bin : histogram) {
+            if (bin > clipLimit) {
+                clipped += bin - clipLimit;
+                bin = clipLimit;
+            }
+        }
+        int batch = clipped / 256, residual = clipped - batch * 256;
+        for (int& bin : histogram) bin += batch;
+        if (residual > 0) {
+            int step = std::max(256 / residual, 1);
+            for (int i = 0; i < 256 && residual > 0; i += step, residual--) histogram[i]++;
+        }
+
+        uint8_t* lut = luts.data() + (size_t(ty) * tilesX + tx) * 256;
+        const float scale = 255.0f / area;
+        int sum = 0;
+        for (int i = 0; i < 256; i++) {
+            sum += histogram[i];
+            lut[i] = uint8_t(std::min(255, int(std::lround(sum * scale))));
+        }
+    }
+
+    /**
+     * Interpolación bilineal de las LUTs de los centros de tesela vecinos (como cv::CLAHE)
+     */
+    void equalizeTile(int tx, int ty) {
+        cv::Rect tile = tileRect(tx, ty);
+        const float inverseTile = 1.0f / kTileSize;
+        int left[kTileSize], right[kTileSize];
+        float weight[kTileSize];
+        for (int i = 0; i < tile.width; i++) {
+            float position = (tile.x + i) * inverseTile - 0.5f;
+            int first = int(std::floor(position));
+            weight[i] = position - first;
+            left[i] = std::max(first, 0);
+            right[i] = std::min(first + 1, tilesX - 1);
+        }
+
+        for (int y = tile.y; y < tile.y + tile.height; y++) {
+            float position = y * inverseTile - 0.5f;
+            int first = int(std::floor(position));
+            float verticalWeight = position - first;
+            const uint8_t* top = luts.data() + size_t(std::max(first, 0)) * tilesX * 256;
+            const uint8_t* bottom = luts.data() + size_t(std::min(first + 1, tilesY - 1)) * tilesX * 256;
+
+            const uint8_t* source = gray.ptr<uint8_t>(y);
+            uint8_t* target = equalized.ptr<uint8_t>(y);
+            for (int i = 0; i < tile.width; i++) {
+                int value = source[tile.x + i];
+                float upper = top[left[i] * 256 + value] * (1.0f - weight[i]) + top[right[i] * 256 + value] * weight[i];
+                float lower = bottom[left[i] * 256 + value] * (1.0f - weight[i]) + bottom[right[i] * 256 + value] * weight[i];
+                target[tile.x + i] = uint8_t(std::min(255, int(std::lround(upper + (lower - upper) * verticalWeight))));
+            }
+        }
+    }
+
+    mutable std::mutex mutex;
+
+    cv::Mat source, rectifyMap1, rectifyMap2;
+    PhotometricGain gain;
+    bool claheEnabled = false;
+
+    cv::Mat gray;
+    cv::Mat equalized;                  // Salida con CLAHE (gray se conserva para las LUTs)
+    std::vector<uint8_t> luts;          // 256 entradas por tesela
+    std::vector<char> lutReady, equalizedReady;
+    std::vector<char> tileReady;
+    int tilesX = 0, tilesY = 0;
+    int tilesRectified = 0;
+};
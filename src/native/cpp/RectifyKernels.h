@@ -0,0 +1,233 @@
+/**
+ * RectifyKernels - Remap bilineal en punto fijo con salida en gris en una sola pasada
+ * Lee BGR (o el plano Y) con los mapas CV_16SC2 + tabla de interpolación de
+ * initUndistortRectifyMap y escribe gris de 8 bits, sin imagen BGR rectificada intermedia
+ */
+
+#pragma once
+
+#include "StereoPreprocess.h"
+
+#include <opencv2/core.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+
+#if defined(__AVX2__) || defined(__SSE4_1__)
+#include <immintrin.h>
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+namespace rectify_kernels {
+
+// Fracción de los mapas CV_16SC2: INTER_BITS = 5 (32 subposiciones por eje)
+constexpr int kInterBits = 5;
+constexpr int kInterTabSize = 1 << kInterBits;
+
+// Luma de cada muestra en Q10 (ganancia incluida) y resultado en Q(10 + 2·5)
+constexpr int kLumaBits = 10;
+constexpr int kResultShift = kLumaBits + 2 * kInterBits;
+
+// Píxeles por bloque: recolección escalar de muestras y mezcla vectorial
+constexpr int kChunk = 64;
+
+struct LumaCoefficients {
+    int32_t b = 0, g = 0, r = 0; // Q10 con la ganancia plegada
+    int32_t y = 0;               // Fuente de un canal (plano Y)
+    int32_t bias = 0;            // Offset fotométrico + redondeo en la escala del resultado
+
+    static LumaCoefficients from(const PhotometricGain& photometric) {
+        const double scale = double(1 << kLumaBits);
+        LumaCoefficients c;
+        c.b = int32_t(std::lround(stereo_preprocess::kWeightB * photometric.gain * scale));
+        c.g = int32_t(std::lround(stereo_preprocess::kWeightG * photometric.gain * scale));
+        c.r = int32_t(std::lround(stereo_preprocess::kWeightR * photometric.gain * scale));
+        c.y = int32_t(std::lround(photometric.gain * scale));
+        c.bias = int32_t(std::lround(photometric.offset * double(1 << kResultShift))) + (1 << (kResultShift - 1));
+        return c;
+    }
+};
+
+/**
+ * Imagen fuente en bruto (BGR de 3 canales o Y de 1 canal)
+ */
+struct SourceView {
+    const uint8_t* data = nullptr;
+    size_t step = 0;
+    int cols = 0, rows = 0;
+    int channels = 3;
+};
+
+template <int Channels>
+inline int32_t sampleLuma(const uint8_t* pixel, const LumaCoefficients& c) {
+    if constexpr (Channels == 3) {
+        return pixel[0] * c.b + pixel[1] * c.g + pixel[2] * c.r;
+    } else {
+        return pixel[0] * c.y;
+    }
+}
+
+/**
+ * Mezcla bilineal de n píxeles: top = t00·32 + (t01 - t00)·fx, bottom igual,
+ * v = top·32 + (bottom - top)·fy; salida saturada a 8 bits
+ */
+inline void blendScalar(const int32_t* t00, const int32_t* t01, const int32_t* t10, const int32_t* t11,
+                        const int32_t* fx, const int32_t* fy, int32_t bias, uint8_t* dst, int begin, int n) {
+    for (int i = begin; i < n; i++) {
+        int32_t top = (t00[i] << kInterBits) + (t01[i] - t00[i]) * fx[i];
+        int32_t bottom = (t10[i] << kInterBits) + (t11[i] - t10[i]) * fx[i];
+        int32_t value = ((top << kInterBits) + (bottom - top) * fy[i] + bias) >> kResultShift;
+        dst[i] = uint8_t(std::min(255, std::max(0, value)));
+    }
+}
+
+inline void blendChunk(const int32_t* t00, const int32_t* t01, const int32_t* t10, const int32_t* t11,
+                       const int32_t* fx, const int32_t* fy, int32_t bias, uint8_t* dst, int n) {
+    int i = 0;
+#if defined(__AVX2__)
+    const __m256i biasVec = _mm256_set1_epi32(bias);
+    for (; i + 8 <= n; i += 8) {
+        __m256i a = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(t00 + i));
+        __m256i b = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(t01 + i));
+        __m256i c = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(t10 + i));
+        __m256i d = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(t11 + i));
+        __m256i wx = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(fx + i));
+        __m256i wy = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(fy + i));
+
+        __m256i top = _mm256_add_epi32(_mm256_slli_epi32(a, kInterBits), _mm256_mullo_epi32(_mm256_sub_epi32(b, a), wx));
+        __m256i bottom = _mm256_add_epi32(_mm256_slli_epi32(c, kInterBits), _mm256_mullo_epi32(_mm256_sub_epi32(d, c), wx));
+        __m256i value = _mm256_add_epi32(_mm256_slli_epi32(top, kInterBits), _mm256_mullo_epi32(_mm256_sub_epi32(bottom, top), wy));
+        value = _mm256_srai_epi32(_mm256_add_epi32(value, biasVec), kResultShift);
+
+        __m128i words = _mm_packs_epi32(_mm256_castsi256_si128(value), _mm256_extracti128_si256(value, 1));
+        _mm_storel_epi64(reinterpret_cast<__m128i*>(dst + i), _mm_packus_epi16(words, words));
+    }
+#elif defined(__SSE4_1__)
+    const __m128i biasVec = _mm_set1_epi32(bias);
+    for (; i + 4 <= n; i += 4) {
+        __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(t00 + i));
+        __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(t01 + i));
+        __m128i c = _mm_loadu_si128(reinterpret_cast<const __m128i*>(t10 + i));
+        __m128i d = _mm_loadu_si128(reinterpret_cast<const __m128i*>(t11 + i));
+        __m128i wx = _mm_loadu_si128(reinterpret_cast<const __m128i*>(fx + i));
+        __m128i wy = _mm_loadu_si128(reinterpret_cast<const __m128i*>(fy + i));
+
+        __m128i top = _mm_add_epi32(_mm_slli_epi32(a, kInterBits), _mm_mullo_epi32(_mm_sub_epi32(b, a), wx));
+        __m128i bottom = _mm_add_epi32(_mm_slli_epi32(c, kInterBits), _mm_mullo_epi32(_mm_sub_epi32(d, c), wx));
+        __m128i value = _mm_add_epi32(_mm_slli_epi32(top, kInterBits), _mm_mullo_epi32(_mm_sub_epi32(bottom, top), wy));
+        value = _mm_srai_epi32(_mm_add_epi32(value, biasVec), kResultShift);
+
+        __m128i words = _mm_packs_epi32(value, value);
+        int32_t packed = _mm_cvtsi128_si32(_mm_packus_epi16(words, words));
+        std::memcpy(dst + i, &packed, 4);
+    }
+#elif defined(__ARM_NEON)
+    const int32x4_t biasVec = vdupq_n_s32(bias);
+    for (; i + 8 <= n; i += 8) {
+        int32x4_t values[2];
+        for (int half = 0; half < 2; half++) {
+            int k = i + half * 4;
+            int32x4_t a = vld1q_s32(t00 + k), b = vld1q_s32(t01 + k);
+            int32x4_t c = vld1q_s32(t10 + k), d = vld1q_s32(t11 + k);
+            int32x4_t wx = vld1q_s32(fx + k), wy = vld1q_s32(fy + k);
+
+            int32x4_t top = vmlaq_s32(vshlq_n_s32(a, kInterBits), vsubq_s32(b, a), wx);
+            int32x4_t bottom = vmlaq_s32(vshlq_n_s32(c, kInterBits), vsubq_s32(d, c), wx);
+            int32x4_t value = vmlaq_s32(vshlq_n_s32(top, kInterBits), vsubq_s32(bottom, top), wy);
+            values[half] = vshrq_n_s32(vaddq_s32(value, biasVec), kResultShift);
+        }
+        uint16x8_t words = vcombine_u16(vqmovun_s32(values[0]), vqmovun_s32(values[1]));
+        vst1_u8(dst + i, vqmovn_u16(words));
+    }
+#endif
+    blendScalar(t00, t01, t10, t11, fx, fy, bias, dst, i, n);
+}
+
+/**
+ * Una fila de salida: recolección de las 4 muestras (borde constante 0, como remap)
+ * en bloques de kChunk píxeles y mezcla vectorial de cada bloque
+ */
+template <int Channels>
+inline void remapRowToGray(const SourceView& src, const int16_t* xy, const uint16_t* fractions,
+                           uint8_t* dst, int count, const LumaCoefficients& c) {
+    alignas(32) int32_t t00[kChunk], t01[kChunk], t10[kChunk], t11[kChunk], fx[kChunk], fy[kChunk];
+
+    for (int start = 0; start < count; start += kChunk) {
+        int n = std::min(kChunk, count - start);
+
+        for (int i = 0; i < n; i++) {
+            int x = xy[2 * (start + i)];
+            int y = xy[2 * (start + i) + 1];
+            uint16_t fraction = fractions[start + i];
+            fx[i] = fraction & (kInterTabSize - 1);
+            fy[i] = fraction >> kInterBits;
+
+            if (x >= 0 && y >= 0 && x + 1 < src.cols && y + 1 < src.rows) {
+                const uint8_t* row0 = src.data + size_t(y) * src.step + size_t(x) * Channels;
+                const uint8_t* row1 = row0 + src.step;
+                t00[i] = sampleLuma<Channels>(row0, c);
+                t01[i] = sampleLuma<Channels>(row0 + Channels, c);
+                t10[i] = sampleLuma<Channels>(row1, c);
+                t11[i] = sampleLuma<Channels>(row1 + Channels, c);
+            } else {
+                // Borde: cada muestra fuera de la imagen vale 0
+                auto fetch = [&](int sx, int sy) -> int32_t {
+                    if (sx < 0 || sy < 0 || sx >= src.cols || sy >= src.rows) return 0;
+                    return sampleLuma<Channels>(src.data + size_t(sy) * src.step + size_t(sx) * Channels, c);
+                };
+                t00[i] = fetch(x, y);
+                t01[i] = fetch(x + 1, y);
+                t10[i] = fetch(x, y + 1);
+                t11[i] = fetch(x + 1, y + 1);
+            }
+        }
+
+        blendChunk(t00, t01, t10, t11, fx, fy, c.bias, dst + start, n);
+    }
+}
+
+} // namespace rectify_kernels
+
+/**
+ * remap(INTER_LINEAR) + cvtColor(BGR2GRAY) + ganancia fotométrica en una pasada sobre la
+ * región pedida de la imagen de salida. source: CV_8UC3 (BGR) o CV_8UC1 (plano Y);
+ * map1: CV_16SC2, map2: CV_16UC1 (tabla de initUndistortRectifyMap)
+ */
+inline void remapToGray(const cv::Mat& source, const cv::Mat& map1, const cv::Mat& map2,
+                        cv::Mat& gray, const PhotometricGain& photometric = PhotometricGain(),
+                        cv::Rect region = cv::Rect()) {
+    CV_Assert(source.type() == CV_8UC3 || source.type() == CV_8UC1);
+    CV_Assert(map1.type() == CV_16SC2 && map2.type() == CV_16UC1 && map1.size() == map2.size());
+
+    if (gray.size() != map1.size() || gray.type() != CV_8UC1) {
+        gray.create(map1.size(), CV_8UC1);
+    }
+    if (region.area() == 0) {
+        region = cv::Rect(0, 0, map1.cols, map1.rows);
+    }
+    region &= cv::Rect(0, 0, map1.cols, map1.rows);
+
+    rectify_kernels::SourceView view;
+    view.data = source.data;
+    view.step = source.step;
+    view.cols = source.cols;
+    view.rows = source.rows;
+    view.channels = source.channels();
+
+    const rectify_kernels::LumaCoefficients coefficients = rectify_kernels::LumaCoefficients::from(photometric);
+
+    for (int y = region.y; y < region.y + region.height; y++) {
+        const int16_t* xy = map1.ptr<int16_t>(y) + 2 * region.x;
+        const uint16_t* fractions = map2.ptr<uint16_t>(y) + region.x;
+        uint8_t* dst = gray.ptr<uint8_t>(y) + region.x;
+
+        if (view.channels == 3) {
+            rectify_kernels::remapRowToGray<3>(view, xy, fractions, dst, region.width, coefficients);
+        } else {
+            rectify_kernels::remapRowToGray<1>(view, xy, fractions, dst, region.width, coefficients);
+        }
+    }
+}
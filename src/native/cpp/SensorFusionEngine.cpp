@@ -0,0 +1,267 @@
+/**
+ * SensorFusionEngine - Implementación del filtro de orientación y puente JNI
+ * Sustituye el paso de muestras por JS: el hilo de sensores empuja directamente al anillo nativo
+ */
+
+#include "SensorFusionEngine.h"
+#include <jni.h>
+#include <algorithm>
+#include <iostream>
+
+using namespace std;
+
+SensorFusionEngine::SensorFusionEngine() :
+    sampleSignal(0),
+    running(false),
+    orientationInitialized(false),
+    lastGyroTimestampNs(0),
+    lastAccelTimestampNs(0),
+    poseCount(0),
+    poseHead(0) {
+}
+
+SensorFusionEngine::~SensorFusionEngine() {
+    stop();
+}
+
+shared_ptr<SensorFusionEngine> SensorFusionEngine::instance() {
+    static shared_ptr<SensorFusionEngine> engine = make_shared<SensorFusionEngine>();
+    return engine;
+}
+
+void SensorFusionEngine::start() {
+    bool expected = false;
+    if (!running.compare_exchange_strong(expected, true)) return;
+
+    fusionThread = thread([this] { fusionLoop(); });
+    cout << "🧭 SensorFusionEngine iniciado (filtro Mahony a frecuencia de sensor)" << endl;
+}
+
+void SensorFusionEngine::stop() {
+    bool expected = true;
+    if (!running.compare_exchange_strong(expected, false)) return;
+
+    // Despertar al hilo de fusión bloqueado en la espera del anillo
+    sampleSignal.fetch_add(1, std::memory_order_release);
+    sampleSignal.notify_all();
+    if (fusionThread.joinable()) {
+        fusionThread.join();
+    }
+}
+
+bool SensorFusionEngine::pushSample(const ImuSample& sample) {
+    if (!sampleRing.push(sample)) return false;
+
+    sampleSignal.fetch_add(1, std::memory_order_release);
+    sampleSignal.notify_one();
+    return true;
+}
+
+bool SensorFusionEngine::poseAt(int64_t timestampNs, RigPose& pose) const {
+    lock_guard<mutex> lock(historyMutex);
+    if (poseCount == 0) return false;
+
+    auto at = [this](size_t age) -> const RigPose& {
+        return poseHistory[(poseHead + kPoseHistoryCapacity - 1 - age) % kPoseHistoryCapacity];
+    };
+
+    const RigPose& newest = at(0);
+    const RigPose& oldest = at(poseCount - 1);
+
+    if (timestampNs >= newest.timestampNs) {
+        if (timestampNs - newest.timestampNs > kMaxExtrapolationNs) return false;
+
+        // Extrapolación corta con la última velocidad angular
+        double dt = (timestampNs - newest.timestampNs) * 1e-9;
+        pose = newest;
+        pose.timestampNs = timestampNs;
+        pose.orientation = (newest.orientation * Quaternion::fromAngularVelocity(newest.angularVelocity, dt)).normalized();
+        return true;
+    }
+
+    if (timestampNs < oldest.timestampNs) return false;
+
+    // Búsqueda binaria en el historial ordenado por tiempo (edad 0 = más reciente)
+    size_t lo = 0, hi = poseCount - 1;
+    while (hi - lo > 1) {
+        size_t mid = (lo + hi) / 2;
+        if (at(mid).timestampNs > timestampNs) lo = mid; else hi = mid;
+    }
+
+    const RigPose& after = at(lo);
+    const RigPose& before = at(hi);
+    double span = double(after.timestampNs - before.timestampNs);
+    double t = span > 0.0 ? (timestampNs - before.timestampNs) / span : 0.0;
+
+    pose.timestampNs = timestampNs;
+    pose.orientation = Quaternion::slerp(before.orientation, after.orientation, t);
+    pose.angularVelocity = before.angularVelocity * (1.0 - t) + after.angularVelocity * t;
+    pose.position = before.position * (1.0 - t) + after.position * t;
+    return true;
+}
+
+RigPose SensorFusionEngine::latestPose() const {
+    lock_guard<mutex> lock(historyMutex);
+    if (poseCount == 0) return RigPose();
+    return poseHistory[(poseHead + kPoseHistoryCapacity - 1) % kPoseHistoryCapacity];
+}
+
+void SensorFusionEngine::fusionLoop() {
+    while (running.load(std::memory_order_acquire)) {
+        uint32_t observed = sampleSignal.load(std::memory_order_acquire);
+
+        ImuSample sample;
+        while (sampleRing.pop(sample)) {
+            processSample(sample);
+        }
+
+        // Espera sin sondeo hasta la siguiente muestra (o stop)
+        sampleSignal.wait(observed, std::memory_order_acquire);
+    }
+}
+
+void SensorFusionEngine::processSample(const ImuSample& sample) {
+    Vector3 value(sample.x, sample.y, sample.z);
+
+    switch (sample.kind) {
+        case ImuSensorKind::Accelerometer:
+            integrateAccelerometer(value, sample.timestampNs);
+            break;
+        case ImuSensorKind::Gyroscope:
+            integrateGyro(value, sample.timestampNs);
+            break;
+    }
+}
+
+void SensorFusionEngine::integrateAccelerometer(const Vector3& accel, int64_t timestampNs) {
+    if (!orientationInitialized) {
+        // Inclinación inicial directamente desde la gravedad medida
+        orientation = Quaternion::fromTwoVectors(accel, Vector3(0, 0, 1));
+        filteredAccel = accel;
+        orientationInitialized = true;
+        lastAccelTimestampNs = timestampNs;
+        return;
+    }
+
+    // Paso bajo para la corrección de gravedad del filtro
+    filteredAccel = filteredAccel * 0.8 + accel * 0.2;
+
+    double dt = (timestampNs - lastAccelTimestampNs) * 1e-9;
+    lastAccelTimestampNs = timestampNs;
+    if (dt <= 0.0 || dt > 0.1) return;
+
+    // Aceleración lineal en el mundo e integración con decaimiento de velocidad (limita la deriva)
+    Vector3 linear = orientation.rotate(accel) - Vector3(0, 0, kGravity);
+    velocity = (velocity + linear * dt) * std::max(0.0, 1.0 - dt / kVelocityDecaySeconds);
+    position += velocity * dt;
+}
+
+void SensorFusionEngine::integrateGyro(const Vector3& gyro, int64_t timestampNs) {
+    lastGyro = gyro;
+
+    if (lastGyroTimestampNs == 0 || !orientationInitialized) {
+        lastGyroTimestampNs = timestampNs;
+        return;
+    }
+
+    double dt = (timestampNs - lastGyroTimestampNs) * 1e-9;
+    lastGyroTimestampNs = timestampNs;
+    if (dt <= 0.0 || dt > 0.1) return;
+
+    // Mahony: el error entre la gravedad medida y la estimada corrige la velocidad angular
+    Vector3 omega = gyro;
+    double accelNorm = filteredAccel.norm();
+    if (std::fabs(accelNorm - kGravity) < 0.2 * kGravity) {
+        Vector3 measured = filteredAccel * (1.0 / accelNorm);
+        Vector3 estimated = orientation.conjugate().rotate(Vector3(0, 0, 1));
+        Vector3 error = measured.cross(estimated);
+
+        integralError += error * (kIntegralGain * dt);
+        omega = gyro + error * kProportionalGain + integralError;
+    }
+
+    orientation = (orientation * Quaternion::fromAngularVelocity(omega, dt)).normalized();
+
+    RigPose pose;
+    pose.timestampNs = timestampNs;
+    pose.orientation = orientation;
+    pose.angularVelocity = gyro;
+    pose.position = position;
+    appendPose(pose);
+}
+
+void SensorFusionEngine::appendPose(const RigPose& pose) {
+    lock_guard<mutex> lock(historyMutex);
+    poseHistory[poseHead] = pose;
+    poseHead = (poseHead + 1) % kPoseHistoryCapacity;
+    poseCount = std::min(poseCount + 1, kPoseHistoryCapacity);
+}
+
+// Funciones C para exposición JNI/bridge (SensorFusionModule)
+
+extern "C" {
+    JNIEXPORT void JNICALL
+    Java_com_cammeasurepro_sensorfusion_SensorFusionModule_nativeInitializeFusion(
+        JNIEnv* env, jobject thiz, jint sensorCount) {
+
+        SensorFusionEngine::instance()->start();
+    }
+
+    /**
+     * Muestra individual de acelerómetro (kind 0) o giroscopio (kind 1) con su timestamp de evento
+     */
+    JNIEXPORT void JNICALL
+    Java_com_cammeasurepro_sensorfusion_SensorFusionModule_nativePushImuSample(
+        JNIEnv* env, jobject thiz, jint kind, jfloat x, jfloat y, jfloat z, jlong timestampNs) {
+
+        ImuSample sample;
+        sample.timestampNs = timestampNs;
+        sample.kind = kind == 1 ? ImuSensorKind::Gyroscope : ImuSensorKind::Accelerometer;
+        sample.x = x;
+        sample.y = y;
+        sample.z = z;
+        SensorFusionEngine::instance()->pushSample(sample);
+    }
+
+    /**
+     * Instantánea periódica: la IMU ya llega por nativePushImuSample. El filtro solo usa
+     * giroscopio y gravedad (las etapas de visión necesitan rotaciones relativas, no el
+     * rumbo absoluto), así que magnetómetro y barómetro no se conservan
+     */
+    JNIEXPORT void JNICALL
+    Java_com_cammeasurepro_sensorfusion_SensorFusionModule_nativeProcessSensorData(
+        JNIEnv* env, jobject thiz, jfloatArray accelData, jfloatArray gyroData,
+        jfloatArray magData, jfloatArray baroData, jdoubleArray gpsData, jlong timestamp) {
+    }
+
+    JNIEXPORT jfloatArray JNICALL
+    Java_com_cammeasurepro_sensorfusion_SensorFusionModule_nativeGetFusedOrientation(
+        JNIEnv* env, jobject thiz) {
+
+        Vector3 euler = SensorFusionEngine::instance()->latestPose().orientation.toEuler();
+        jfloat values[3] = { jfloat(euler.x), jfloat(euler.y), jfloat(euler.z) };
+
+        jfloatArray result = env->NewFloatArray(3);
+        env->SetFloatArrayRegion(result, 0, 3, values);
+        return result;
+    }
+
+    JNIEXPORT jfloatArray JNICALL
+    Java_com_cammeasurepro_sensorfusion_SensorFusionModule_nativeGetFusedPosition(
+        JNIEnv* env, jobject thiz) {
+
+        Vector3 position = SensorFusionEngine::instance()->latestPose().position;
+        jfloat values[3] = { jfloat(position.x), jfloat(position.y), jfloat(position.z) };
+
+        jfloatArray result = env->NewFloatArray(3);
+        env->SetFloatArrayRegion(result, 0, 3, values);
+        return result;
+    }
+
+    JNIEXPORT void JNICALL
+    Java_com_cammeasurepro_sensorfusion_SensorFusionModule_nativeCleanupFusion(
+        JNIEnv* env, jobject thiz) {
+
+        SensorFusionEngine::instance()->stop();
+    }
+}
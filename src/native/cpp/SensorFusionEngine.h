@@ -0,0 +1,251 @@
+/**
+ * SensorFusionEngine - Fusión IMU nativa junto al procesador de cámaras
+ * Ingesta lock-free de acelerómetro/giroscopio, filtro de orientación a frecuencia de sensor
+ * e historial de poses interpolable por timestamp de frame
+ *
+ * Convenciones: ejes del dispositivo Android, timestamps en nanosegundos (elapsedRealtimeNanos,
+ * la misma base que SENSOR_TIMESTAMP de Camera2), orientación cuerpo -> mundo (Z mundo = arriba)
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cmath>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+struct Vector3 {
+    double x = 0.0, y = 0.0, z = 0.0;
+
+    Vector3() = default;
+    Vector3(double vx, double vy, double vz) : x(vx), y(vy), z(vz) {}
+
+    Vector3 operator+(const Vector3& v) const { return { x + v.x, y + v.y, z + v.z }; }
+    Vector3 operator-(const Vector3& v) const { return { x - v.x, y - v.y, z - v.z }; }
+    Vector3 operator*(double s) const { return { x * s, y * s, z * s }; }
+    Vector3& operator+=(const Vector3& v) { x += v.x; y += v.y; z += v.z; return *this; }
+
+    double dot(const Vector3& v) const { return x * v.x + y * v.y + z * v.z; }
+    Vector3 cross(const Vector3& v) const {
+        return { y * v.z - z * v.y, z * v.x - x * v.z, x * v.y - y * v.x };
+    }
+    double norm() const { return std::sqrt(dot(*this)); }
+    Vector3 normalized() const {
+        double n = norm();
+        return n > 0.0 ? *this * (1.0 / n) : *this;
+    }
+};
+
+struct Quaternion {
+    double w = 1.0, x = 0.0, y = 0.0, z = 0.0;
+
+    Quaternion() = default;
+    Quaternion(double qw, double qx, double qy, double qz) : w(qw), x(qx), y(qy), z(qz) {}
+
+    Quaternion operator*(const Quaternion& q) const {
+        return {
+            w * q.w - x * q.x - y * q.y - z * q.z,
+            w * q.x + x * q.w + y * q.z - z * q.y,
+            w * q.y - x * q.z + y * q.w + z * q.x,
+            w * q.z + x * q.y - y * q.x + z * q.w
+        };
+    }
+
+    Quaternion conjugate() const { return { w, -x, -y, -z }; }
+
+    Quaternion normalized() const {
+        double n = std::sqrt(w * w + x * x + y * y + z * z);
+        return n > 0.0 ? Quaternion(w / n, x / n, y / n, z / n) : Quaternion();
+    }
+
+    Vector3 rotate(const Vector3& v) const {
+        Quaternion r = *this * Quaternion(0.0, v.x, v.y, v.z) * conjugate();
+        return { r.x, r.y, r.z };
+    }
+
+    /**
+     * Rotación de velocidad angular omega (rad/s) durante dt segundos (mapa exponencial)
+     */
+    static Quaternion fromAngularVelocity(const Vector3& omega, double dt) {
+        double angle = omega.norm() * dt;
+        if (angle < 1e-12) {
+            return Quaternion(1.0, omega.x * dt * 0.5, omega.y * dt * 0.5, omega.z * dt * 0.5).normalized();
+        }
+        Vector3 axis = omega.normalized();
+        double s = std::sin(angle * 0.5);
+        return { std::cos(angle * 0.5), axis.x * s, axis.y * s, axis.z * s };
+    }
+
+    /**
+     * Rotación mínima que lleva la dirección from a la dirección to
+     */
+    static Quaternion fromTwoVectors(const Vector3& from, const Vector3& to) {
+        Vector3 f = from.normalized(), t = to.normalized();
+        double d = f.dot(t);
+        if (d < -0.999999) {
+            // Vectores opuestos: giro de 180° sobre cualquier eje perpendicular
+            Vector3 axis = Vector3(1, 0, 0).cross(f);
+            if (axis.norm() < 1e-6) axis = Vector3(0, 1, 0).cross(f);
+            axis = axis.normalized();
+            return { 0.0, axis.x, axis.y, axis.z };
+        }
+        Vector3 c = f.cross(t);
+        return Quaternion(1.0 + d, c.x, c.y, c.z).normalized();
+    }
+
+    static Quaternion slerp(const Quaternion& a, Quaternion b, double t) {
+        double cosTheta = a.w * b.w + a.x * b.x + a.y * b.y + a.z * b.z;
+        if (cosTheta < 0.0) {
+            b = Quaternion(-b.w, -b.x, -b.y, -b.z);
+            cosTheta = -cosTheta;
+        }
+        if (cosTheta > 0.9995) {
+            return Quaternion(a.w + (b.w - a.w) * t, a.x + (b.x - a.x) * t,
+                              a.y + (b.y - a.y) * t, a.z + (b.z - a.z) * t).normalized();
+        }
+        double theta = std::acos(cosTheta);
+        double wa = std::sin((1.0 - t) * theta) / std::sin(theta);
+        double wb = std::sin(t * theta) / std::sin(theta);
+        return { wa * a.w + wb * b.w, wa * a.x + wb * b.x, wa * a.y + wb * b.y, wa * a.z + wb * b.z };
+    }
+
+    /**
+     * Ángulos de Euler (roll, pitch, yaw) en radianes
+     */
+    Vector3 toEuler() const {
+        double roll = std::atan2(2.0 * (w * x + y * z), 1.0 - 2.0 * (x * x + y * y));
+        double sinPitch = std::max(-1.0, std::min(1.0, 2.0 * (w * y - z * x)));
+        double pitch = std::asin(sinPitch);
+        double yaw = std::atan2(2.0 * (w * z + x * y), 1.0 - 2.0 * (y * y + z * z));
+        return { roll, pitch, yaw };
+    }
+};
+
+enum class ImuSensorKind : uint8_t {
+    Accelerometer = 0,
+    Gyroscope = 1
+};
+
+struct ImuSample {
+    int64_t timestampNs = 0;
+    ImuSensorKind kind = ImuSensorKind::Accelerometer;
+    float x = 0.0f, y = 0.0f, z = 0.0f;
+};
+
+/**
+ * Pose del rig en un instante: orientación cuerpo -> mundo, velocidad angular (cuerpo)
+ * y posición integrada (con deriva; útil solo en ventanas cortas)
+ */
+struct RigPose {
+    int64_t timestampNs = 0;
+    Quaternion orientation;
+    Vector3 angularVelocity;
+    Vector3 position;
+};
+
+/**
+ * Cola circular lock-free de un productor y un consumidor
+ */
+template <typename T, size_t Capacity>
+class SpscRing {
+    static_assert((Capacity & (Capacity - 1)) == 0, "La capacidad debe ser potencia de 2");
+
+public:
+    bool push(const T& value) {
+        size_t head = headIndex.load(std::memory_order_relaxed);
+        if (head - tailIndex.load(std::memory_order_acquire) >= Capacity) {
+            return false; // Llena: se descarta la muestra antes que bloquear al productor
+        }
+        buffer[head & (Capacity - 1)] = value;
+        headIndex.store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+    bool pop(T& value) {
+        size_t tail = tailIndex.load(std::memory_order_relaxed);
+        if (tail == headIndex.load(std::memory_order_acquire)) {
+            return false;
+        }
+        value = buffer[tail & (Capacity - 1)];
+        tailIndex.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+private:
+    std::array<T, Capacity> buffer{};
+    alignas(64) std::atomic<size_t> headIndex{0};
+    alignas(64) std::atomic<size_t> tailIndex{0};
+};
+
+class SensorFusionEngine {
+public:
+    SensorFusionEngine();
+    ~SensorFusionEngine();
+
+    /**
+     * Instancia de proceso: hay una sola IMU por dispositivo, compartida por todos los procesadores
+     */
+    static std::shared_ptr<SensorFusionEngine> instance();
+
+    void start();
+    void stop();
+    bool isRunning() const { return running.load(std::memory_order_acquire); }
+
+    /**
+     * Ingesta desde el hilo de sensores (productor único); no bloquea
+     */
+    bool pushSample(const ImuSample& sample);
+
+    /**
+     * Pose interpolada en un timestamp (ns). Devuelve false si está fuera del historial
+     */
+    bool poseAt(int64_t timestampNs, RigPose& pose) const;
+
+    /**
+     * Última pose estimada
+     */
+    RigPose latestPose() const;
+
+private:
+    static constexpr size_t kSampleRingCapacity = 4096;
+    static constexpr size_t kPoseHistoryCapacity = 2048; // ~4 s a 500 Hz
+    static constexpr int64_t kMaxExtrapolationNs = 20000000; // 20 ms
+
+    // Ganancias del filtro complementario de Mahony
+    static constexpr double kProportionalGain = 0.5;
+    static constexpr double kIntegralGain = 0.005;
+    static constexpr double kGravity = 9.80665;
+    static constexpr double kVelocityDecaySeconds = 1.0;
+
+    void fusionLoop();
+    void processSample(const ImuSample& sample);
+    void integrateGyro(const Vector3& gyro, int64_t timestampNs);
+    void integrateAccelerometer(const Vector3& accel, int64_t timestampNs);
+    void appendPose(const RigPose& pose);
+
+    SpscRing<ImuSample, kSampleRingCapacity> sampleRing;
+    std::atomic<uint32_t> sampleSignal; // Cambia en cada push/stop para atomic::wait
+    std::atomic<bool> running;
+    std::thread fusionThread;
+
+    // Estado del filtro (solo lo toca el hilo de fusión)
+    Quaternion orientation;
+    Vector3 integralError;
+    Vector3 filteredAccel;
+    Vector3 lastGyro;
+    Vector3 velocity;
+    Vector3 position;
+    bool orientationInitialized;
+    int64_t lastGyroTimestampNs;
+    int64_t lastAccelTimestampNs;
+
+    // Historial de poses compartido con las etapas de visión
+    mutable std::mutex historyMutex;
+    std::array<RigPose, kPoseHistoryCapacity> poseHistory;
+    size_t poseCount;
+    size_t poseHead;
+};
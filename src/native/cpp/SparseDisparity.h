@@ -0,0 +1,95 @@
+/**
+ * SparseDisparity - Rango de disparidad de la escena a partir de correspondencias dispersas
+ * Esquinas de la imagen izquierda rectificada buscadas a lo largo de su fila en la derecha
+ * (SAD de parche, búsqueda exhaustiva con prueba de unicidad); los percentiles de las
+ * disparidades aceptadas acotan la búsqueda de SGBM sin priori temporal
+ */
+
+#pragma once
+
+#include <opencv2/core.hpp>
+#include <opencv2/imgproc.hpp>
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <vector>
+
+namespace sparse_disparity {
+
+constexpr int kPatchRadius = 4;         // Parche 9x9, como el bloque de SGBM
+constexpr int kMaxSamples = 256;
+constexpr int kMinSamples = 24;         // Por debajo, la estimación no es fiable
+constexpr float kUniqueness = 0.8f;     // Mejor coste < 0.8 x segundo mejor no adyacente
+constexpr double kLowPercentile = 0.02;
+constexpr double kHighPercentile = 0.98;
+
+/**
+ * Disparidad entera de una esquina por SAD en [0, searchLimit); -1 si es ambigua
+ */
+inline int matchAlongRow(const cv::Mat& left, const cv::Mat& right, int x, int y, int searchLimit) {
+    int maxDisparity = std::min(searchLimit, x - kPatchRadius + 1);
+    int bestCost = INT32_MAX, secondCost = INT32_MAX, bestDisparity = -1;
+    std::vector<int> costs(std::max(maxDisparity, 0));
+
+    for (int d = 0; d < maxDisparity; d++) {
+        int cost = 0;
+        for (int dy = -kPatchRadius; dy <= kPatchRadius; dy++) {
+            const uint8_t* leftRow = left.ptr<uint8_t>(y + dy) + x - kPatchRadius;
+            const uint8_t* rightRow = right.ptr<uint8_t>(y + dy) + x - d - kPatchRadius;
+            for (int dx = 0; dx <= 2 * kPatchRadius; dx++) {
+                cost += std::abs(int(leftRow[dx]) - int(rightRow[dx]));
+            }
+        }
+        costs[d] = cost;
+        if (cost < bestCost) {
+            bestCost = cost;
+            bestDisparity = d;
+        }
+    }
+    if (bestDisparity < 0) return -1;
+
+    for (int d = 0; d < maxDisparity; d++) {
+        if (std::abs(d - bestDisparity) > 1) secondCost = std::min(secondCost, costs[d]);
+    }
+    return bestCost < kUniqueness * secondCost ? bestDisparity : -1;
+}
+
+/**
+ * Rango [minDisparity, minDisparity + numDisparities) que cubre la escena en la franja, con
+ * margen y múltiplo de 16, dentro de [0, searchLimit). false si hay pocas correspondencias
+ */
+inline bool estimateDisparityRange(const cv::Mat& left, const cv::Mat& right, cv::Rect band, int searchLimit,
+                                   int margin, int& minDisparity, int& numDisparities, int* samples = nullptr) {
+    std::vector<cv::Point2f> corners;
+    cv::goodFeaturesToTrack(left(band), corners, kMaxSamples, 0.01, std::max(8, band.width / 32));
+
+    std::vector<int> disparities;
+    disparities.reserve(corners.size());
+    for (const cv::Point2f& corner : corners) {
+        int x = cvRound(corner.x) + band.x, y = cvRound(corner.y) + band.y;
+        if (x + kPatchRadius >= left.cols || y - kPatchRadius < band.y || y + kPatchRadius >= band.y + band.height) {
+            continue;
+        }
+        int disparity = matchAlongRow(left, right, x, y, searchLimit);
+        if (disparity >= 0) disparities.push_back(disparity);
+    }
+    if (samples != nullptr) *samples = int(disparities.size());
+    if (int(disparities.size()) < kMinSamples) return false;
+
+    // Percentiles robustos a los emparejamientos erróneos que pasan la prueba de unicidad
+    auto percentile = [&disparities](double fraction) {
+        auto nth = disparities.begin() + std::min<size_t>(disparities.size() - 1, size_t(fraction * disparities.size()));
+        std::nth_element(disparities.begin(), nth, disparities.end());
+        return *nth;
+    };
+    int low = std::max(0, percentile(kLowPercentile) - margin);
+    int high = percentile(kHighPercentile) + margin;
+
+    int limit = std::max(16, searchLimit / 16 * 16);
+    numDisparities = std::min(limit, ((high - low + 1 + 15) / 16) * 16);
+    minDisparity = std::max(0, std::min(low, limit - numDisparities));
+    return true;
+}
+
+} // namespace sparse_disparity
@@ -0,0 +1,187 @@
+/**
+ * StageGraph - Grafo de etapas del pipeline y modos de procesamiento
+ * Cada etapa declara sus entradas; un modo pide salidas y solo se ejecuta su cierre
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+
+// Orden topológico: toda etapa aparece después de sus entradas
+enum class PipelineStage : int {
+    ExposureMatch = 0,  // Ganancia de exposición de cada cámara respecto a la izquierda
+    Rectify,            // Rectificación epipolar a gris normalizado por cámara
+    StereoMatch,        // Disparidad SGBM del par estéreo
+    Reproject,          // Disparidad -> XYZ con la matriz Q
+    DepthFilter,        // Filtrado bilateral del mapa de profundidad
+    DepthIntegrals,     // Imágenes integrales de X, Y, Z, Z² y píxeles válidos
+    SurfaceNormals,     // Normales por gradiente 3D medio sobre las integrales
+    FeatureDetect,      // Detección y descripción SIFT por cámara
+    FeatureTrack,       // Seguimiento KLT temporal con predicción del giroscopio
+    FeatureMatch,       // Emparejamiento de descriptores del par estéreo
+    Triangulate,        // Triangulación DLT de las correspondencias
+    DepthStatistics,    // Estadísticas e incertidumbre de profundidad
+    PlaneDetect,        // Plano dominante con priori de gravedad (RANSAC 1/2 puntos)
+    SurfaceMesh,        // Malla de la profundidad decimada al presupuesto de triángulos
+    CalibrationCorners, // Captura de esquinas del patrón de calibración
+    Count
+};
+
+using StageMask = uint32_t;
+
+constexpr int kStageCount = static_cast<int>(PipelineStage::Count);
+
+constexpr StageMask stageBit(PipelineStage stage) {
+    return StageMask(1) << static_cast<int>(stage);
+}
+
+struct StageDescriptor {
+    PipelineStage stage;
+    const char* name;
+    StageMask inputs;
+};
+
+inline const std::array<StageDescriptor, kStageCount>& stageDescriptors() {
+    static const std::array<StageDescriptor, kStageCount> descriptors = {{
+        { PipelineStage::ExposureMatch,      "exposure",     0 },
+        { PipelineStage::Rectify,            "rectify",      stageBit(PipelineStage::ExposureMatch) },
+        { PipelineStage::StereoMatch,        "sgbm",         stageBit(PipelineStage::Rectify) },
+        { PipelineStage::Reproject,          "reproject",    stageBit(PipelineStage::StereoMatch) },
+        { PipelineStage::DepthFilter,        "bilateral",    stageBit(PipelineStage::Reproject) },
+        { PipelineStage::DepthIntegrals,     "integrals",    stageBit(PipelineStage::DepthFilter) },
+        { PipelineStage::SurfaceNormals,     "normals",      stageBit(PipelineStage::DepthIntegrals) },
+        { PipelineStage::FeatureDetect,      "sift",         0 },
+        { PipelineStage::FeatureTrack,       "klt",          stageBit(PipelineStage::Rectify) },
+        { PipelineStage::FeatureMatch,       "match",        stageBit(PipelineStage::FeatureDetect) },
+        { PipelineStage::Triangulate,        "triangulate",  stageBit(PipelineStage::FeatureMatch) },
+        { PipelineStage::DepthStatistics,    "stats",        stageBit(PipelineStage::DepthFilter) },
+        { PipelineStage::PlaneDetect,        "plane",        stageBit(PipelineStage::DepthFilter) },
+        { PipelineStage::SurfaceMesh,        "mesh",         stageBit(PipelineStage::DepthFilter) },
+        { PipelineStage::CalibrationCorners, "calib-corners", 0 },
+    }};
+    return descriptors;
+}
+
+// Versión de una salida: hash de sus fuentes (frame, calibración, parámetros) y de sus entradas
+using StageVersion = uint64_t;
+
+constexpr StageVersion kStageNeverComputed = 0;
+
+inline StageVersion mixVersion(StageVersion seed, uint64_t value) {
+    // Combinación estilo boost::hash_combine con finalizador splitmix64
+    uint64_t x = seed ^ (value + 0x9e3779b97f4a7c15ULL + (seed << 6) + (seed >> 2));
+    x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    x = (x ^ (x >> 27)) * 0x94d049bb133111ebULL;
+    x ^= x >> 31;
+    return x == kStageNeverComputed ? 1 : x;
+}
+
+inline const char* stageName(PipelineStage stage) {
+    return stageDescriptors()[static_cast<int>(stage)].name;
+}
+
+// Entradas efectivas de cada etapa: las del descriptor más las que añade la configuración
+using StageInputs = std::array<StageMask, kStageCount>;
+
+inline StageInputs defaultStageInputs() {
+    StageInputs inputs{};
+    for (int i = 0; i < kStageCount; i++) {
+        inputs[i] = stageDescriptors()[i].inputs;
+    }
+    return inputs;
+}
+
+/**
+ * Cierre transitivo de entradas: todas las etapas necesarias para producir las pedidas
+ */
+inline StageMask resolveStageClosure(StageMask requested, const StageInputs& inputs) {
+    StageMask closure = requested;
+
+    // Recorrido inverso: las entradas siempre tienen índice menor que la etapa
+    for (int i = kStageCount - 1; i >= 0; i--) {
+        if (closure & (StageMask(1) << i)) {
+            closure |= inputs[i];
+        }
+    }
+    return closure;
+}
+
+/**
+ * Nivel de cada etapa en el grafo (0 = sin entradas). Etapas del mismo nivel son
+ * independientes entre sí y pueden ejecutarse concurrentemente
+ */
+inline std::array<int, kStageCount> computeStageLevels(const StageInputs& inputs) {
+    std::array<int, kStageCount> levels{};
+    for (int i = 0; i < kStageCount; i++) {
+        for (int input = 0; input < i; input++) {
+            if (inputs[i] & (StageMask(1) << input)) {
+                levels[i] = std::max(levels[i], levels[input] + 1);
+            }
+        }
+    }
+    return levels;
+}
+
+enum class FeatureMatchMode : int {
+    BruteForce = 0,     // Todos los descriptores de la derecha con validación cruzada
+    DisparityGuided     // Solo los keypoints cercanos a la posición predicha por la disparidad densa
+};
+
+/**
+ * Entradas con el modo de emparejamiento: el guiado espera a la disparidad SGBM
+ * (deja de correr en paralelo con ella y la añade al cierre de los modos que triangulan)
+ */
+inline StageInputs stageInputsForMatchMode(FeatureMatchMode mode) {
+    StageInputs inputs = defaultStageInputs();
+    if (mode == FeatureMatchMode::DisparityGuided) {
+        inputs[static_cast<int>(PipelineStage::FeatureMatch)] |= stageBit(PipelineStage::StereoMatch);
+    }
+    return inputs;
+}
+
+enum class ProcessingMode : int {
+    PreviewDepth = 0,       // Profundidad densa rápida, sin SIFT ni triangulación
+    SparseMeasurement,      // Puntos 3D triangulados para medición
+    FullReconstruction,     // Todas las salidas
+    CalibrationCapture      // Solo acumulación de esquinas de calibración
+};
+
+/**
+ * Salidas que pide cada modo (el cierre añade sus dependencias)
+ */
+inline StageMask requestedOutputsForMode(ProcessingMode mode) {
+    switch (mode) {
+        case ProcessingMode::PreviewDepth:
+            return stageBit(PipelineStage::Reproject);
+        case ProcessingMode::SparseMeasurement:
+            return stageBit(PipelineStage::Triangulate) |
+                   stageBit(PipelineStage::FeatureTrack);
+        case ProcessingMode::FullReconstruction:
+            return stageBit(PipelineStage::DepthStatistics) |
+                   stageBit(PipelineStage::PlaneDetect) |
+                   stageBit(PipelineStage::Triangulate) |
+                   stageBit(PipelineStage::FeatureTrack);
+        case ProcessingMode::CalibrationCapture:
+            return stageBit(PipelineStage::CalibrationCorners);
+    }
+    return 0;
+}
+
+/**
+ * Nivel de la pirámide de rectificación (escala 1/2^nivel) con el que trabaja cada modo
+ */
+inline int processingLevelForMode(ProcessingMode mode) {
+    return mode == ProcessingMode::PreviewDepth ? 1 : 0;
+}
+
+inline const char* processingModeName(ProcessingMode mode) {
+    switch (mode) {
+        case ProcessingMode::PreviewDepth:       return "preview-depth";
+        case ProcessingMode::SparseMeasurement:  return "sparse-measurement";
+        case ProcessingMode::FullReconstruction: return "full-reconstruction";
+        case ProcessingMode::CalibrationCapture: return "calibration-capture";
+    }
+    return "unknown";
+}
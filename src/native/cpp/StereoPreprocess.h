@@ -0,0 +1,136 @@
+/**
+ * StereoPreprocess - Conversión a gris con normalización fotométrica en una sola pasada
+ * La ganancia/offset respecto a la cámara de referencia se pliega en los coeficientes
+ * de luma, de modo que gris + normalización cuestan lo mismo que un cvtColor
+ */
+
+#pragma once
+
+#include <opencv2/core.hpp>
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdint>
+
+/**
+ * Percentiles bajo/alto de la luma de una región
+ */
+struct LumaRange {
+    double low = 0.0;
+    double high = 255.0;
+    bool valid = false;
+};
+
+/**
+ * Transformación afín de intensidad: y' = gain * y + offset
+ */
+struct PhotometricGain {
+    double gain = 1.0;
+    double offset = 0.0;
+
+    /**
+     * Ajuste que lleva el rango [low, high] de source al de reference
+     */
+    static PhotometricGain matching(const LumaRange& source, const LumaRange& reference) {
+        PhotometricGain result;
+        if (!source.valid || !reference.valid || source.high - source.low < 8.0) return result;
+
+        // Ganancia acotada: diferencias mayores indican escenas distintas, no exposición
+        result.gain = std::clamp((reference.high - reference.low) / (source.high - source.low), 0.5, 2.0);
+        result.offset = reference.low - result.gain * source.low;
+        return result;
+    }
+
+    /**
+     * Suavizado temporal para que la corrección no parpadee entre frames
+     */
+    PhotometricGain blended(const PhotometricGain& measured, double weight) const {
+        PhotometricGain result;
+        result.gain = gain + (measured.gain - gain) * weight;
+        result.offset = offset + (measured.offset - offset) * weight;
+        return result;
+    }
+};
+
+namespace stereo_preprocess {
+
+// Pesos de luma BT.601 en punto fijo Q14
+constexpr int kLumaShift = 14;
+constexpr double kWeightB = 0.114, kWeightG = 0.587, kWeightR = 0.299;
+
+inline int lumaQ14(const uint8_t* bgr) {
+    return bgr[0] * 1868 + bgr[1] * 9617 + bgr[2] * 4899;
+}
+
+} // namespace stereo_preprocess
+
+/**
+ * Percentiles 5/95 de la luma en una región BGR, muestreando uno de cada step píxeles
+ */
+inline LumaRange measureLumaRange(const cv::Mat& bgr, cv::Rect region, int step = 4) {
+    LumaRange range;
+    region &= cv::Rect(0, 0, bgr.cols, bgr.rows);
+    if (bgr.type() != CV_8UC3 || region.area() == 0) return range;
+
+    std::array<int, 256> histogram{};
+    int samples = 0;
+    for (int y = region.y; y < region.y + region.height; y += step) {
+        const uint8_t* row = bgr.ptr<uint8_t>(y);
+        for (int x = region.x; x < region.x + region.width; x += step) {
+            histogram[stereo_preprocess::lumaQ14(row + 3 * x) >> stereo_preprocess::kLumaShift]++;
+            samples++;
+        }
+    }
+    if (samples < 64) return range;
+
+    int lowTarget = samples * 5 / 100, highTarget = samples * 95 / 100;
+    int accumulated = 0;
+    bool lowFound = false;
+    for (int value = 0; value < 256; value++) {
+        accumulated += histogram[value];
+        if (!lowFound && accumulated > lowTarget) {
+            range.low = value;
+            lowFound = true;
+        }
+        if (accumulated > highTarget) {
+            range.high = value;
+            break;
+        }
+    }
+    range.valid = true;
+    return range;
+}
+
+/**
+ * BGR -> gris normalizado en una pasada: y' = sat((cB·b + cG·g + cR·r + off) >> 14), con la
+ * ganancia incluida en los coeficientes (opcionalmente solo en una región). Bucle sin
+ * dependencias entre píxeles y aritmética entera de 32 bits, apto para autovectorización
+ */
+inline void convertToNormalizedGray(const cv::Mat& bgr, cv::Mat& gray, const PhotometricGain& photometric,
+                                    cv::Rect region = cv::Rect()) {
+    CV_Assert(bgr.type() == CV_8UC3);
+    if (gray.size() != bgr.size() || gray.type() != CV_8UC1) {
+        gray.create(bgr.size(), CV_8UC1);
+    }
+    if (region.area() == 0) {
+        region = cv::Rect(0, 0, bgr.cols, bgr.rows);
+    }
+    region &= cv::Rect(0, 0, bgr.cols, bgr.rows);
+
+    const double scale = double(1 << stereo_preprocess::kLumaShift);
+    const int32_t cB = int32_t(std::lround(stereo_preprocess::kWeightB * photometric.gain * scale));
+    const int32_t cG = int32_t(std::lround(stereo_preprocess::kWeightG * photometric.gain * scale));
+    const int32_t cR = int32_t(std::lround(stereo_preprocess::kWeightR * photometric.gain * scale));
+    const int32_t bias = int32_t(std::lround(photometric.offset * scale)) + (1 << (stereo_preprocess::kLumaShift - 1));
+
+    for (int y = region.y; y < region.y + region.height; y++) {
+        const uint8_t* src = bgr.ptr<uint8_t>(y);
+        uint8_t* dst = gray.ptr<uint8_t>(y);
+        for (int x = region.x; x < region.x + region.width; x++) {
+            int32_t value = (src[3 * x] * cB + src[3 * x + 1] * cG + src[3 * x + 2] * cR + bias)
+                            >> stereo_preprocess::kLumaShift;
+            dst[x] = uint8_t(std::min(255, std::max(0, value)));
+        }
+    }
+}
@@ -0,0 +1,203 @@
+/**
+ * SubpixelRefiner - Refinamiento subpíxel por lotes de esquinas y keypoints
+ * Mismo criterio que cornerSubPix (el vector punto -> píxel es ortogonal al gradiente en
+ * la ventana, ponderado con máscara gaussiana), sobre un lote en disposición SoA que se
+ * reparte por bloques entre hilos. Cada iteración muestrea la ventana completa con los
+ * mismos 4 pesos bilineales (la fracción es común a toda la ventana) y acumula los
+ * productos de gradiente en acumuladores por columna: bucles sin dependencias entre
+ * columnas que el compilador vectoriza. Estado de convergencia por punto
+ */
+
+#pragma once
+
+#include <opencv2/core.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+namespace subpixel {
+
+constexpr int kMaxHalfWindow = 11;                  // winSize (11, 11) de las esquinas de calibración
+constexpr int kMaxPatch = 2 * kMaxHalfWindow + 3;  // Ventana + borde de 1 para el gradiente
+constexpr float kMinDeterminantRatio = 1e-3f;       // det/traza² mínimo: por debajo, borde recto
+constexpr float kMinGradientEnergy = 4.0f;          // |∇I|² medio mínimo (niveles de gris²)
+
+enum class Status : uint8_t {
+    Pending = 0,
+    Converged,          // Desplazamiento por debajo de epsilon
+    MaxIterations,      // Sin converger en el máximo de iteraciones (posición refinada)
+    Degenerate,         // Zona plana o borde recto: se conserva la posición inicial
+    OutOfBounds,        // La ventana sale de la imagen: se conserva la posición inicial
+    Diverged            // Se alejó más de media ventana: se conserva la posición inicial
+};
+
+/**
+ * Lote de puntos en SoA: las posiciones se refinan en sitio
+ */
+struct PointBatch {
+    std::vector<float> x, y;
+    std::vector<Status> status;
+    std::vector<uint8_t> iterations;
+
+    int size() const {
+        return int(x.size());
+    }
+
+    void assign(const std::vector<cv::Point2f>& points) {
+        x.resize(points.size());
+        y.resize(points.size());
+        for (size_t i = 0; i < points.size(); i++) {
+            x[i] = points[i].x;
+            y[i] = points[i].y;
+        }
+        status.assign(points.size(), Status::Pending);
+        iterations.assign(points.size(), 0);
+    }
+
+    void store(std::vector<cv::Point2f>& points) const {
+        points.resize(x.size());
+        for (size_t i = 0; i < x.size(); i++) {
+            points[i] = cv::Point2f(x[i], y[i]);
+        }
+    }
+
+    int count(Status value) const {
+        return int(std::count(status.begin(), status.end(), value));
+    }
+};
+
+class SubpixelRefiner {
+public:
+    /**
+     * Ventana (2·halfWindow + 1)², como winSize = (halfWindow, halfWindow) de cornerSubPix
+     */
+    explicit SubpixelRefiner(int halfWindow = 5, int maxIterations = 30, float epsilon = 0.01f)
+        : half(std::min(std::max(halfWindow, 1), kMaxHalfWindow)),
+          maxIterations(std::max(1, std::min(maxIterations, 255))),
+          epsilonSquared(epsilon * epsilon) {
+        int side = 2 * half + 1;
+        mask.resize(side);
+        offsets.resize(side);
+        float coefficient = 1.0f / float(half * half);
+        for (int i = 0; i < side; i++) {
+            offsets[i] = float(i - half);
+            mask[i] = std::exp(-offsets[i] * offsets[i] * coefficient);
+        }
+        maskSum = 0.0f;
+        for (int i = 0; i < side; i++) {
+            for (int j = 0; j < side; j++) maskSum += mask[i] * mask[j];
+        }
+    }
+
+    int halfWindow() const {
+        return half;
+    }
+
+    /**
+     * Refina los puntos [begin, end) del lote sobre gray (CV_8UC1). Rangos disjuntos del
+     * mismo lote pueden refinarse concurrentemente
+     */
+    void refine(const cv::Mat& gray, PointBatch& batch, int begin, int end) const {
+        const int side = 2 * half + 1, patchSide = side + 2;
+        alignas(32) float patch[kMaxPatch * kMaxPatch];
+        alignas(32) float gxx[kMaxPatch], gxy[kMaxPatch], gyy[kMaxPatch], bx[kMaxPatch], by[kMaxPatch];
+
+        for (int i = begin; i < end; i++) {
+            const float startX = batch.x[i], startY = batch.y[i];
+            float cx = startX, cy = startY;
+            Status status = Status::MaxIterations;
+            int iteration = 0;
+
+            while (iteration < maxIterations) {
+                iteration++;
+
+                // Muestreo bilineal de la ventana con borde: píxeles [ix - half - 1, ix + half + 2]
+                int ix = int(std::floor(cx)), iy = int(std::floor(cy));
+                float fx = cx - float(ix), fy = cy - float(iy);
+                int left = ix - half - 1, top = iy - half - 1;
+                if (left < 0 || top < 0 || left + patchSide >= gray.cols || top + patchSide >= gray.rows) {
+                    status = Status::OutOfBounds;
+                    break;
+                }
+                float w00 = (1.0f - fx) * (1.0f - fy), w01 = fx * (1.0f - fy);
+                float w10 = (1.0f - fx) * fy, w11 = fx * fy;
+                for (int r = 0; r < patchSide; r++) {
+                    const uint8_t* row0 = gray.ptr<uint8_t>(top + r) + left;
+                    const uint8_t* row1 = row0 + gray.step;
+                    float* target = patch + r * patchSide;
+                    for (int c = 0; c < patchSide; c++) {
+                        target[c] = w00 * row0[c] + w01 * row0[c + 1] + w10 * row1[c] + w11 * row1[c + 1];
+                    }
+                }
+
+                // Acumuladores por columna (independientes entre columnas)
+                for (int c = 0; c < side; c++) {
+                    gxx[c] = gxy[c] = gyy[c] = bx[c] = by[c] = 0.0f;
+                }
+                for (int r = 0; r < side; r++) {
+                    const float* above = patch + r * patchSide + 1;
+                    const float* center = above + patchSide;
+                    const float* below = center + patchSide;
+                    const float rowMask = mask[r], py = offsets[r];
+                    for (int c = 0; c < side; c++) {
+                        float gx = 0.5f * (center[c + 1] - center[c - 1]);
+                        float gy = 0.5f * (below[c] - above[c]);
+                        float m = rowMask * mask[c];
+                        float xx = gx * gx * m, xy = gx * gy * m, yy = gy * gy * m;
+                        gxx[c] += xx;
+                        gxy[c] += xy;
+                        gyy[c] += yy;
+                        bx[c] += xx * offsets[c] + xy * py;
+                        by[c] += xy * offsets[c] + yy * py;
+                    }
+                }
+
+                double a = 0, b = 0, c2 = 0, bb1 = 0, bb2 = 0;
+                for (int c = 0; c < side; c++) {
+                    a += gxx[c];
+                    b += gxy[c];
+                    c2 += gyy[c];
+                    bb1 += bx[c];
+                    bb2 += by[c];
+                }
+
+                double trace = a + c2, determinant = a * c2 - b * b;
+                if (trace < kMinGradientEnergy * maskSum || determinant <= kMinDeterminantRatio * trace * trace) {
+                    status = Status::Degenerate;
+                    break;
+                }
+
+                double dx = (c2 * bb1 - b * bb2) / determinant;
+                double dy = (a * bb2 - b * bb1) / determinant;
+                cx += float(dx);
+                cy += float(dy);
+                if (dx * dx + dy * dy <= epsilonSquared) {
+                    status = Status::Converged;
+                    break;
+                }
+            }
+
+            if (status == Status::Converged || status == Status::MaxIterations) {
+                if (std::fabs(cx - startX) > half || std::fabs(cy - startY) > half) status = Status::Diverged;
+            }
+            if (status == Status::Converged || status == Status::MaxIterations) {
+                batch.x[i] = cx;
+                batch.y[i] = cy;
+            }
+            batch.status[i] = status;
+            batch.iterations[i] = uint8_t(iteration);
+        }
+    }
+
+private:
+    int half;
+    int maxIterations;
+    float epsilonSquared;
+    std::vector<float> mask;        // Gaussiana 1D: la máscara 2D es mask[r]·mask[c]
+    std::vector<float> offsets;     // Desplazamiento de cada fila/columna respecto al centro
+    float maskSum;
+};
+
+} // namespace subpixel
@@ -0,0 +1,153 @@
+/**
+ * ThreadPool - Pool de hilos compartible entre instancias del procesador
+ * Cola FIFO simple con futures y parallelFor por bloques
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <condition_variable>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+class ThreadPool {
+public:
+    explicit ThreadPool(size_t threadCount = 0) : stopping(false) {
+        if (threadCount == 0) {
+            threadCount = std::max(1u, std::thread::hardware_concurrency());
+        }
+
+        workers.reserve(threadCount);
+        for (size_t i = 0; i < threadCount; i++) {
+            workers.emplace_back([this] { workerLoop(); });
+        }
+    }
+
+    ~ThreadPool() {
+        {
+            std::lock_guard<std::mutex> lock(queueMutex);
+            stopping = true;
+        }
+        queueCondition.notify_all();
+
+        for (auto& worker : workers) {
+            worker.join();
+        }
+    }
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    size_t size() const {
+        return workers.size();
+    }
+
+    /**
+     * Encola una tarea y devuelve un future con su resultado
+     */
+    template <typename F>
+    auto submit(F&& task) -> std::future<typename std::invoke_result<F>::type> {
+        using Result = typename std::invoke_result<F>::type;
+
+        auto packaged = std::make_shared<std::packaged_task<Result()>>(std::forward<F>(task));
+        std::future<Result> result = packaged->get_future();
+
+        {
+            std::lock_guard<std::mutex> lock(queueMutex);
+            tasks.emplace([packaged] { (*packaged)(); });
+        }
+        queueCondition.notify_one();
+
+        return result;
+    }
+
+    /**
+     * Encola una tarea sin resultado (reanudación de corrutinas)
+     */
+    void post(std::function<void()> task) {
+        {
+            std::lock_guard<std::mutex> lock(queueMutex);
+            tasks.emplace(std::move(task));
+        }
+        queueCondition.notify_one();
+    }
+
+    /**
+     * Ejecuta body(i) para i en [begin, end) repartido en bloques entre los hilos
+     * Llamado desde un hilo del propio pool se ejecuta en serie para evitar bloqueos
+     */
+    void parallelFor(int begin, int end, const std::function<void(int)>& body) {
+        int count = end - begin;
+        if (count <= 0) return;
+
+        if (count == 1 || workers.size() <= 1 || isWorkerThread()) {
+            for (int i = begin; i < end; i++) {
+                body(i);
+            }
+            return;
+        }
+
+        int chunks = std::min<int>(count, static_cast<int>(workers.size()));
+        int chunkSize = (count + chunks - 1) / chunks;
+
+        std::vector<std::future<void>> pending;
+        pending.reserve(chunks);
+        for (int chunkBegin = begin + chunkSize; chunkBegin < end; chunkBegin += chunkSize) {
+            int chunkEnd = std::min(end, chunkBegin + chunkSize);
+            pending.push_back(submit([&body, chunkBegin, chunkEnd] {
+                for (int i = chunkBegin; i < chunkEnd; i++) {
+                    body(i);
+                }
+            }));
+        }
+
+        // El hilo llamador procesa el primer bloque mientras los demás trabajan
+        for (int i = begin; i < std::min(end, begin + chunkSize); i++) {
+            body(i);
+        }
+
+        for (auto& future : pending) {
+            future.get();
+        }
+    }
+
+private:
+    std::vector<std::thread> workers;
+    std::queue<std::function<void()>> tasks;
+    std::mutex queueMutex;
+    std::condition_variable queueCondition;
+    bool stopping;
+
+    static const ThreadPool*& currentPool() {
+        static thread_local const ThreadPool* pool = nullptr;
+        return pool;
+    }
+
+    bool isWorkerThread() const {
+        return currentPool() == this;
+    }
+
+    void workerLoop() {
+        currentPool() = this;
+
+        while (true) {
+            std::function<void()> task;
+            {
+                std::unique_lock<std::mutex> lock(queueMutex);
+                queueCondition.wait(lock, [this] { return stopping || !tasks.empty(); });
+
+                if (stopping && tasks.empty()) return;
+
+                task = std::move(tasks.front());
+                tasks.pop();
+            }
+            task();
+        }
+    }
+};